@@ -4,83 +4,54 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include "AccountTable.h"
 
 class Transaction;
 
+// A view over one row of the bank's AccountTable; all state lives in the
+// table's columns. Views are created on demand by Bank::getAccount and may
+// be used from any thread with no lock held: the row stays in place and
+// resident while a view exists. deposit and withdraw are atomic
+// compare-and-swap updates of the balance (Bank runs them on temporary
+// views); everything else a view only reads. PINs, lock state and history
+// change through Bank, under its shard lock.
 class Account {
 protected:
-    std::string accountNumber;
-    std::string pin;
-    double balance;
-    std::vector<std::shared_ptr<Transaction>> transactionHistory;
-    bool isLocked;
-    int failedLoginAttempts;
+    AccountTable& table;
+    size_t row;
 
 public:
-    Account(const std::string& accNum, const std::string& pinCode, double initialBalance = 0.0)
-        : accountNumber(accNum), pin(pinCode), balance(initialBalance), isLocked(false), failedLoginAttempts(0) {}
+    Account(AccountTable& accountTable, size_t tableRow)
+        : table(accountTable), row(tableRow) {}
     
     virtual ~Account() = default;
 
     virtual std::string displayAccountType() const = 0;
 
-    std::string getAccountNumber() const { return accountNumber; }
-    std::string getPin() const { return pin; }
-    double getBalance() const { return balance; }
-
-    void setPin(const std::string& newPin) { pin = newPin; }
+    std::string getAccountNumber() const { return table.accountNumber(row); }
+    double getBalance() const { return table.balance(row); }
 
     //# start operations 
     virtual bool deposit(double amount) {
         if (amount > 0) {
-            balance += amount;
-            return true;
+            return table.adjustBalance(row, AccountTable::toCents(amount), 0);
         }
         return false;
     }
 
     virtual bool withdraw(double amount) {
-        if (amount > 0 && balance >= amount) {
-            balance -= amount;
-            return true;
+        if (amount > 0) {
+            return table.adjustBalance(row, -AccountTable::toCents(amount), 0);
         }
         return false;
     }
 
-    void addTransaction(std::shared_ptr<Transaction> trans) {
-        transactionHistory.push_back(trans);
-    }
-
-    const std::vector<std::shared_ptr<Transaction>>& getTransactionHistory() const {
-        return transactionHistory;
-    }
-	
-
-	//# might remove interest we will see about this
-    virtual void applyInterest(double rate) { 
-        // Default implementation does nothing
-    }
-
     // Lock management methods
-    bool getIsLocked() const { return isLocked; }
-    
-    void lockCard() { isLocked = true; }
+    bool getIsLocked() const { return table.isLocked(row); }
     
-    void unlockCard() {
-        isLocked = false;
-        failedLoginAttempts = 0;
-    }
-    
-    int getFailedLoginAttempts() const { return failedLoginAttempts; }
-    
-    void incrementFailedAttempts() { failedLoginAttempts++; }
-    
-    void resetFailedAttempts() { failedLoginAttempts = 0; }
-    
-    void setLockedStatus(bool locked, int attempts) {
-        isLocked = locked;
-        failedLoginAttempts = attempts;
-    }
+    int getFailedLoginAttempts() const { return table.failedAttempts(row); }
+
+    size_t getRow() const { return row; }
 };
 
 #endif // ACCOUNT_H
\ No newline at end of file
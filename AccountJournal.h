@@ -0,0 +1,140 @@
+#ifndef ACCOUNTJOURNAL_H
+#define ACCOUNTJOURNAL_H
+
+#include <string>
+#include <fstream>
+#include <cstddef>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <filesystem>
+#include <system_error>
+#include "MappedFile.h"
+
+// Append-only write-ahead journal for account mutations.
+// Every record is one full account row in the same format as the snapshot
+// file, so replaying the journal is just re-applying rows in order (the last
+// row for a card number wins).
+class AccountJournal {
+private:
+    std::string path;
+    std::ofstream out;
+    std::ifstream reader;
+    size_t recordCount{0};
+    uint64_t endOffset{0};
+    // Bytes at the start of the file that replay applied; the first append
+    // cuts the file back to this.
+    uint64_t validEnd{0};
+    bool scanned{false};
+
+    template <typename Fn>
+    size_t scan(Fn&& applyRow) {
+        scanned = true;
+        validEnd = 0;
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return 0;
+
+        size_t replayed = 0;
+        bool sawMarker = false;
+        std::vector<std::pair<std::string, uint64_t>> group;
+        std::string line;
+        uint64_t offset = 0;
+        uint64_t linesEnd = 0;     // end of the last complete line
+        uint64_t committedEnd = 0; // end of the last commit marker
+        while (std::getline(file, line)) {
+            uint64_t lineOffset = offset;
+            offset += line.size() + 1;
+            if (file.eof()) break;
+            linesEnd = offset;
+            if (line.empty() || line == "\r") continue;
+            if (line[0] == '#') {
+                sawMarker = true;
+                committedEnd = offset;
+                for (const auto& row : group) applyRow(row.first, row.second);
+                replayed += group.size();
+                group.clear();
+                continue;
+            }
+            group.emplace_back(line, lineOffset);
+        }
+        if (!sawMarker) {
+            for (const auto& row : group) applyRow(row.first, row.second);
+            replayed += group.size();
+        }
+        validEnd = sawMarker ? committedEnd : linesEnd;
+        return replayed;
+    }
+
+    // Drops what replay did not apply (a torn line, or a group whose commit
+    // marker never reached disk), so the next group's marker cannot adopt
+    // it and the next row is not glued onto a torn one.
+    void truncateTail() {
+        std::error_code ec;
+        if (std::filesystem::exists(path, ec) && std::filesystem::file_size(path, ec) > validEnd) {
+            std::filesystem::resize_file(path, validEnd, ec);
+        }
+    }
+
+public:
+    explicit AccountJournal(const std::string& file) : path(file) {}
+
+    // Feeds every committed record to applyRow(line, byteOffset). Records are
+    // written in groups terminated by a "#commit" marker, and a group only
+    // takes effect once its marker is on disk, so a crash mid-group drops the
+    // whole group. Journals written before commit markers existed have none
+    // and are applied row by row; a trailing line without a newline is a torn
+    // write either way. Whatever is not applied is cut off before the next
+    // append.
+    template <typename Fn>
+    size_t replay(Fn&& applyRow) {
+        size_t replayed = scan(applyRow);
+        recordCount += replayed;
+        return replayed;
+    }
+
+    // Appends a group of rows (each newline-terminated) plus its commit marker
+    // with a single write, and syncs the file: once this returns the group
+    // survives a power loss, not just a crash. Returns the byte offset of the
+    // first row.
+    uint64_t appendGroup(const std::string& rows, size_t rowCount) {
+        if (!out.is_open()) {
+            if (!scanned) scan([](const std::string&, uint64_t) {});
+            truncateTail();
+            endOffset = validEnd;
+            out.open(path, std::ios::app | std::ios::binary);
+        }
+        uint64_t start = endOffset;
+        if (rowCount == 0) return start;
+        std::string record = rows;
+        record += "#commit," + std::to_string(rowCount) + "\n";
+        out.write(record.data(), static_cast<std::streamsize>(record.size()));
+        out.flush();
+        MappedFile::syncFile(path);
+        endOffset += record.size();
+        recordCount += rowCount;
+        return start;
+    }
+
+    // Reads back the row written at byteOffset (see appendGroup / replay).
+    bool readRow(uint64_t byteOffset, std::string& line) {
+        if (!reader.is_open()) reader.open(path, std::ios::binary);
+        reader.clear();
+        reader.seekg(static_cast<std::streamoff>(byteOffset));
+        return static_cast<bool>(std::getline(reader, line));
+    }
+
+    // Drops all records; called once their effect is in a fresh snapshot.
+    void reset() {
+        if (out.is_open()) out.close();
+        if (reader.is_open()) reader.close();
+        out.open(path, std::ios::trunc | std::ios::binary);
+        recordCount = 0;
+        endOffset = 0;
+        validEnd = 0;
+        scanned = true;
+    }
+
+    size_t size() const { return recordCount; }
+};
+
+#endif // ACCOUNTJOURNAL_H
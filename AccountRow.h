@@ -0,0 +1,132 @@
+#ifndef ACCOUNTROW_H
+#define ACCOUNTROW_H
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+
+// One account as it appears in bank_accounts.dat / bank_accounts.journal:
+// card,pin,balance,type,name,locked,failedAttempts[,overdraftLimit]
+// Text fields are views into the buffer the row was parsed from (usually a
+// memory-mapped file), so parsing allocates nothing.
+struct AccountRow {
+    std::string_view accountNumber;
+    std::string_view pin;
+    double balance{0.0};
+    std::string_view accountType;
+    std::string_view holderName;
+    bool locked{false};
+    int failedAttempts{0};
+    // Only written for accounts whose limit is not the default.
+    bool hasOverdraftLimit{false};
+    double overdraftLimit{0.0};
+};
+
+// Parses "123", "-123.4" and "123.45" exactly with integer from_chars; any
+// other spelling (exponents, long fractions from older files, amounts too
+// large for cents in a long long) falls back to strtod on a small stack
+// copy. A sign is only allowed once, in front, and the result must be a
+// finite number: what strtod alone would also take (leading whitespace,
+// "inf", "nan", hex) is rejected.
+inline bool parseAmount(std::string_view text, double& out) {
+    if (text.empty()) return false;
+    const char* first = text.data();
+    const char* last = first + text.size();
+    bool negative = (*first == '-');
+    if (negative) ++first;
+    // A digit or '.' must follow: from_chars would take a second sign
+    // ("--5") as the number's own, and strtod would skip whitespace.
+    if (first == last || !((*first >= '0' && *first <= '9') || *first == '.')) return false;
+
+    long long whole = 0;
+    auto [ptr, ec] = std::from_chars(first, last, whole);
+    if (ec == std::errc() && ptr != first) {
+        if (ptr == last) {
+            out = negative ? -static_cast<double>(whole) : static_cast<double>(whole);
+            return true;
+        }
+        size_t fracDigits = static_cast<size_t>(last - ptr - 1);
+        if (*ptr == '.' && fracDigits >= 1 && fracDigits <= 2 && ptr[1] >= '0' && ptr[1] <= '9' &&
+            whole <= (LLONG_MAX - 99) / 100) {
+            long long frac = 0;
+            auto [fracEnd, fracEc] = std::from_chars(ptr + 1, last, frac);
+            if (fracEc == std::errc() && fracEnd == last) {
+                long long cents = whole * 100 + (fracDigits == 1 ? frac * 10 : frac);
+                out = static_cast<double>(negative ? -cents : cents) / 100.0;
+                return true;
+            }
+        }
+    }
+
+    char buf[64];
+    if (text.size() >= sizeof(buf)) return false;
+    for (const char* p = first; p != last; ++p) {
+        if (!((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '-' || *p == '+')) return false;
+    }
+    std::memcpy(buf, text.data(), text.size());
+    buf[text.size()] = '\0';
+    char* end = nullptr;
+    out = std::strtod(buf, &end);
+    return end == buf + text.size() && std::isfinite(out);
+}
+
+// Splits off the next comma-separated field; the last field runs to the end.
+inline std::string_view nextField(std::string_view& rest) {
+    size_t comma = rest.find(',');
+    std::string_view field = rest.substr(0, comma);
+    rest = (comma == std::string_view::npos) ? std::string_view() : rest.substr(comma + 1);
+    return field;
+}
+
+inline bool parseAccountRow(std::string_view line, AccountRow& row) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    std::string_view rest = line;
+    row.accountNumber = nextField(rest);
+    row.pin = nextField(rest);
+    std::string_view balanceText = nextField(rest);
+    row.accountType = nextField(rest);
+    row.holderName = nextField(rest);
+    std::string_view lockedText = nextField(rest);
+    std::string_view attemptsText = nextField(rest);
+    std::string_view limitText = rest;
+
+    if (row.accountNumber.empty() || !parseAmount(balanceText, row.balance)) return false;
+    // Load failed attempts if present (for backward compatibility, default to 0)
+    row.failedAttempts = 0;
+    if (!attemptsText.empty()) {
+        auto [ptr, ec] = std::from_chars(attemptsText.data(), attemptsText.data() + attemptsText.size(),
+                                         row.failedAttempts);
+        if (ec != std::errc()) return false;
+    }
+    row.hasOverdraftLimit = !limitText.empty();
+    if (row.hasOverdraftLimit && (!parseAmount(limitText, row.overdraftLimit) || row.overdraftLimit < 0)) return false;
+    if (row.holderName.empty()) row.holderName = "Unknown";
+    row.locked = (lockedText == "1");
+    return true;
+}
+
+// Calls fn(line) for every newline-terminated line in [data, data + size);
+// a final line without a newline is passed too. Returns the line count.
+template <typename Fn>
+size_t forEachLine(const char* data, size_t size, Fn&& fn) {
+    size_t lines = 0;
+    const char* cur = data;
+    const char* end = data + size;
+    while (cur < end) {
+        const char* nl = static_cast<const char*>(std::memchr(cur, '\n', static_cast<size_t>(end - cur)));
+        const char* lineEnd = nl ? nl : end;
+        if (lineEnd > cur) {
+            fn(std::string_view(cur, static_cast<size_t>(lineEnd - cur)));
+            lines++;
+        }
+        cur = lineEnd + 1;
+    }
+    return lines;
+}
+
+#endif // ACCOUNTROW_H
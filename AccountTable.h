@@ -0,0 +1,420 @@
+#ifndef ACCOUNTTABLE_H
+#define ACCOUNTTABLE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "Transaction.h"
+
+class Account;
+
+// Struct-of-arrays storage for resident accounts. The fields bulk operations
+// scan (balance, type, lock flag, failed attempts) each live in their own
+// contiguous column, so a pass over every account streams through a few
+// dense arrays instead of chasing one heap object per account. Account
+// objects are thin views over a row (see Account.h).
+//
+// Rows are never moved: each column is a series of segments that are
+// allocated as the table grows and never reallocated, and released rows go
+// on a free list and are reused by later appends. A view can therefore read
+// its row with no lock held while other rows are appended.
+//
+// Balances are fixed-point cents in atomic cells and change through
+// compare-and-swap loops, so concurrent deposits and withdrawals on the same
+// account need no lock between them. The lock flag and failed-attempt count
+// are atomic too, so views read them without a lock. Everything else
+// (appending, releasing, PINs, history) needs the table to itself; Bank
+// guarantees that by holding its shard lock exclusively.
+class AccountTable {
+public:
+    enum : uint8_t { TYPE_SAVINGS = 0, TYPE_CHECKING = 1 };
+    static constexpr uint32_t FREE_ROW = UINT32_MAX;
+    // How far below zero a checking account may go unless its row says
+    // otherwise.
+    static constexpr int64_t DEFAULT_OVERDRAFT_LIMIT_CENTS = 50000;
+
+    // One account's fields, used to fill a row.
+    struct Entry {
+        uint32_t card{0};
+        std::string accountNumber;
+        std::string pin;
+        std::string holderName;
+        double balance{0.0};
+        uint8_t type{TYPE_CHECKING};
+        bool locked{false};
+        int failedAttempts{0};
+        int64_t overdraftLimitCents{DEFAULT_OVERDRAFT_LIMIT_CENTS};
+    };
+
+    // Transactions each account keeps in memory unless set otherwise.
+    static constexpr size_t DEFAULT_HISTORY_CAPACITY = 32;
+
+    // What an applyEndOfDay pass changed.
+    struct EndOfDayTotals {
+        size_t credited{0};
+        int64_t interestCents{0};
+        size_t charged{0};
+        int64_t feeCents{0};
+    };
+
+private:
+    // Rows applyEndOfDay computes at a time.
+    static constexpr size_t END_OF_DAY_BLOCK = 256;
+
+    // int64 <-> double without cvtsi2sd / cvttsd2si, which SSE2 and AVX2 only
+    // have for one lane: adding 1.5 * 2^52 puts a value's integer part in
+    // the low mantissa bits, so the conversion is an integer add plus a bit
+    // copy. Exact for |x| < 2^51 under the default round-to-nearest mode.
+    static constexpr double ROUNDING_BIAS = 6755399441055744.0;
+    static constexpr uint64_t ROUNDING_BIAS_BITS = 0x4338000000000000;
+    static constexpr double EXACT_CENTS = 1125899906842624.0; // 2^50
+
+    static double exactDouble(int64_t x) {
+        const uint64_t bits = static_cast<uint64_t>(x) + ROUNDING_BIAS_BITS;
+        double d;
+        std::memcpy(&d, &bits, sizeof d);
+        return d - ROUNDING_BIAS;
+    }
+    // x must already be a whole number.
+    static int64_t exactCents(double x) {
+        const double biased = x + ROUNDING_BIAS;
+        uint64_t bits;
+        std::memcpy(&bits, &biased, sizeof bits);
+        return static_cast<int64_t>(bits - ROUNDING_BIAS_BITS);
+    }
+
+    // Segment k of every column holds FIRST_SEGMENT_ROWS << k rows, starting
+    // at row FIRST_SEGMENT_ROWS * (2^k - 1), so capacity doubles per segment
+    // like a vector's without ever copying. MAX_SEGMENTS covers every 32-bit
+    // row index.
+    static constexpr size_t FIRST_SEGMENT_SHIFT = 6;
+    static constexpr size_t FIRST_SEGMENT_ROWS = size_t(1) << FIRST_SEGMENT_SHIFT;
+    static constexpr size_t MAX_SEGMENTS = 27;
+
+    static size_t floorLog2(size_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - static_cast<size_t>(__builtin_clzll(static_cast<unsigned long long>(x)));
+#else
+        size_t k = 0;
+        while (x >>= 1) ++k;
+        return k;
+#endif
+    }
+
+    static size_t segmentOf(size_t row) { return floorLog2((row >> FIRST_SEGMENT_SHIFT) + 1); }
+    static size_t segmentStart(size_t segment) { return ((size_t(1) << segment) - 1) << FIRST_SEGMENT_SHIFT; }
+    static size_t segmentRows(size_t segment) { return FIRST_SEGMENT_ROWS << segment; }
+
+    // One column's storage. The segment directory is a fixed array, so
+    // adding a segment touches no memory a reader of another row uses.
+    template <typename T>
+    class Column {
+    private:
+        std::unique_ptr<T[]> segments[MAX_SEGMENTS];
+
+    public:
+        void allocate(size_t segment) { segments[segment].reset(new T[segmentRows(segment)]()); }
+
+        T& operator[](size_t row) {
+            const size_t segment = segmentOf(row);
+            return segments[segment][row - segmentStart(segment)];
+        }
+        const T& operator[](size_t row) const {
+            const size_t segment = segmentOf(row);
+            return segments[segment][row - segmentStart(segment)];
+        }
+    };
+
+    // A column cell for fields updated concurrently.
+    template <typename T>
+    struct AtomicCell {
+        std::atomic<T> value;
+
+        AtomicCell() : value(T()) {}
+    };
+
+    // An account's most recent transactions in a fixed-capacity ring: entries
+    // grows to the table's history capacity on first use, after which each
+    // new transaction overwrites the oldest one at next. Older transactions
+    // are only in the transaction log.
+    struct History {
+        std::vector<Transaction> entries;
+        uint32_t next{0};
+        uint64_t added{0};
+    };
+
+    // Hot columns.
+    Column<AtomicCell<int64_t>> balanceCents;
+    Column<uint8_t> types;
+    Column<int64_t> overdraftLimits;
+    Column<AtomicCell<uint8_t>> lockedFlags;
+    Column<AtomicCell<int32_t>> failedAttemptCounts;
+    // Set by the first change since the account was last committed.
+    Column<AtomicCell<uint8_t>> dirtyFlags;
+    // Set by accesses that cannot reorder Bank's LRU list (see markUsed).
+    Column<AtomicCell<uint8_t>> usedFlags;
+    // Cold columns, only touched one account at a time.
+    Column<uint32_t> cards;
+    Column<std::string> accountNumbers;
+    Column<std::string> pins;
+    Column<std::string> holderNames;
+    Column<History> histories;
+    Column<std::weak_ptr<Account>> views;
+
+    size_t rowCount{0};
+    size_t segmentCount{0};
+    std::vector<size_t> freeRows;
+    size_t historyCapacity{DEFAULT_HISTORY_CAPACITY};
+
+    size_t capacity() const { return segmentStart(segmentCount); }
+
+    void addSegment() {
+        balanceCents.allocate(segmentCount);
+        types.allocate(segmentCount);
+        overdraftLimits.allocate(segmentCount);
+        lockedFlags.allocate(segmentCount);
+        failedAttemptCounts.allocate(segmentCount);
+        dirtyFlags.allocate(segmentCount);
+        usedFlags.allocate(segmentCount);
+        cards.allocate(segmentCount);
+        accountNumbers.allocate(segmentCount);
+        pins.allocate(segmentCount);
+        holderNames.allocate(segmentCount);
+        histories.allocate(segmentCount);
+        views.allocate(segmentCount);
+        segmentCount++;
+    }
+
+public:
+    static const char* typeName(uint8_t type) {
+        return type == TYPE_SAVINGS ? "Savings Account" : "Checking Account";
+    }
+
+    static uint8_t typeFromName(std::string_view name) {
+        return name == "Savings Account" ? TYPE_SAVINGS : TYPE_CHECKING;
+    }
+
+    static int64_t toCents(double amount) { return static_cast<int64_t>(std::llround(amount * 100.0)); }
+    static double fromCents(int64_t cents) { return static_cast<double>(cents) / 100.0; }
+
+    // Number of rows including released ones; see isLive.
+    size_t size() const { return rowCount; }
+    size_t liveCount() const { return rowCount - freeRows.size(); }
+    bool isLive(size_t row) const { return cards[row] != FREE_ROW; }
+
+    void reserve(size_t n) {
+        while (capacity() < n && segmentCount < MAX_SEGMENTS) addSegment();
+    }
+
+    size_t append(Entry&& entry) {
+        size_t row;
+        if (!freeRows.empty()) {
+            row = freeRows.back();
+            freeRows.pop_back();
+        } else {
+            if (rowCount == capacity()) addSegment();
+            row = rowCount++;
+        }
+        assign(row, std::move(entry));
+        return row;
+    }
+
+    void assign(size_t row, Entry&& entry) {
+        setBalance(row, entry.balance);
+        types[row] = entry.type;
+        overdraftLimits[row] = entry.overdraftLimitCents;
+        setLocked(row, entry.locked);
+        setFailedAttempts(row, entry.failedAttempts);
+        cards[row] = entry.card;
+        accountNumbers[row] = std::move(entry.accountNumber);
+        pins[row] = std::move(entry.pin);
+        holderNames[row] = std::move(entry.holderName);
+    }
+
+    void release(size_t row) {
+        cards[row] = FREE_ROW;
+        clearDirty(row);
+        usedFlags[row].value.store(0, std::memory_order_relaxed);
+        std::string().swap(accountNumbers[row]);
+        std::string().swap(pins[row]);
+        std::string().swap(holderNames[row]);
+        histories[row] = History();
+        views[row].reset();
+        freeRows.push_back(row);
+    }
+
+    int64_t cents(size_t row) const { return balanceCents[row].value.load(std::memory_order_relaxed); }
+    double balance(size_t row) const { return fromCents(cents(row)); }
+    void setBalance(size_t row, double balance) { balanceCents[row].value.store(toCents(balance), std::memory_order_relaxed); }
+
+    // Adds delta cents unless a debit would leave the balance below floor.
+    // Lock-free: retries if another thread changed the balance in between.
+    bool adjustBalance(size_t row, int64_t delta, int64_t floor) {
+        std::atomic<int64_t>& cell = balanceCents[row].value;
+        int64_t current = cell.load(std::memory_order_relaxed);
+        do {
+            if (delta < 0 && current + delta < floor) return false;
+        } while (!cell.compare_exchange_weak(current, current + delta, std::memory_order_relaxed));
+        return true;
+    }
+
+    // Adds balance * rate, rounded to the cent.
+    void applyRate(size_t row, double rate) {
+        std::atomic<int64_t>& cell = balanceCents[row].value;
+        int64_t current = cell.load(std::memory_order_relaxed);
+        while (!cell.compare_exchange_weak(current, current + std::llround(static_cast<double>(current) * rate),
+                                           std::memory_order_relaxed)) {
+        }
+    }
+
+    // End-of-day pass over rows [begin, end): savings balances gain
+    // balance * rate rounded to the cent (as applyRate), and checking balances
+    // below zero pay feeCents, though never past their own overdraft limit.
+    // Balances, limits and per-row masks are copied out a block at a time,
+    // and the arithmetic is a loop with no branches and no int64 <-> double
+    // conversion instructions (see exactDouble), which GCC vectorizes at -O3
+    // on plain SSE2: two rows per instruction, four with AVX2. Rows too large
+    // for that to be exact are redone with applyRate's llround. Rows whose
+    // balance changed are written back and appended to changedRows.
+    // Caller keeps every other writer out (Bank holds the shard exclusively).
+    void applyEndOfDay(size_t begin, size_t end, double rate, int64_t feeCents, std::vector<uint32_t>& changedRows,
+                       EndOfDayTotals& totals) {
+        int64_t before[END_OF_DAY_BLOCK];
+        int64_t limits[END_OF_DAY_BLOCK];
+        int64_t after[END_OF_DAY_BLOCK];
+        int64_t savings[END_OF_DAY_BLOCK];  // all ones for a live savings row
+        int64_t checking[END_OF_DAY_BLOCK]; // all ones for a live checking row
+        const double fee = exactDouble(feeCents);
+        // Below this, balance, balance * rate and balance + limit all stay
+        // under 2^51, where exactDouble and exactCents are exact. A fee past
+        // 2^50 sends every row the slow way.
+        const int64_t exactCentsLimit = static_cast<int64_t>(EXACT_CENTS);
+        int64_t exactLimit = static_cast<int64_t>(EXACT_CENTS / std::max(1.0, std::fabs(rate)));
+        if (feeCents >= exactCentsLimit) exactLimit = -1;
+        for (size_t base = begin; base < end; base += END_OF_DAY_BLOCK) {
+            const size_t n = std::min(END_OF_DAY_BLOCK, end - base);
+            for (size_t i = 0; i < n; ++i) {
+                const bool live = cards[base + i] != FREE_ROW;
+                before[i] = balanceCents[base + i].value.load(std::memory_order_relaxed);
+                limits[i] = overdraftLimits[base + i];
+                savings[i] = -static_cast<int64_t>(live && types[base + i] == TYPE_SAVINGS);
+                checking[i] = -static_cast<int64_t>(live && types[base + i] != TYPE_SAVINGS);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                const double cents = exactDouble(before[i]);
+                // llround: round to nearest even, then push exact halves
+                // away from zero.
+                const double x = cents * rate;
+                const double rounded = (x + ROUNDING_BIAS) - ROUNDING_BIAS;
+                const double up = (x - rounded == 0.5) & (x > 0) ? 1.0 : 0.0;
+                const double down = (x - rounded == -0.5) & (x < 0) ? 1.0 : 0.0;
+                const int64_t interest = exactCents(rounded + up - down);
+                // min(fee, max(cents + limit, 0)), as max(a, 0) = (a + |a|) / 2.
+                const double headroom = cents + exactDouble(limits[i]);
+                const double room = 0.5 * (headroom + std::fabs(headroom));
+                const double owed = fee - 0.5 * ((fee - room) + std::fabs(fee - room));
+                const int64_t negative = -static_cast<int64_t>(static_cast<uint64_t>(before[i]) >> 63);
+                // Wraps rather than overflows for the rows redone below.
+                after[i] = static_cast<int64_t>(static_cast<uint64_t>(before[i]) + (savings[i] & interest) -
+                                                (checking[i] & negative & exactCents(owed)));
+            }
+            for (size_t i = 0; i < n; ++i) {
+                if (before[i] > exactLimit || before[i] < -exactLimit || limits[i] >= exactCentsLimit ||
+                    limits[i] <= -exactCentsLimit) {
+                    after[i] = before[i];
+                    if (savings[i]) {
+                        after[i] += std::llround(static_cast<double>(before[i]) * rate);
+                    } else if (checking[i] && before[i] < 0) {
+                        after[i] -= std::min(feeCents, std::max<int64_t>(before[i] + limits[i], 0));
+                    }
+                }
+                if (after[i] == before[i]) continue;
+                balanceCents[base + i].value.store(after[i], std::memory_order_relaxed);
+                changedRows.push_back(static_cast<uint32_t>(base + i));
+                if (savings[i]) {
+                    totals.credited++;
+                    totals.interestCents += after[i] - before[i];
+                } else {
+                    totals.charged++;
+                    totals.feeCents += before[i] - after[i];
+                }
+            }
+        }
+    }
+
+    // markDirty returns true only for the call that set the flag.
+    bool markDirty(size_t row) { return dirtyFlags[row].value.exchange(1, std::memory_order_relaxed) == 0; }
+    void clearDirty(size_t row) { dirtyFlags[row].value.store(0, std::memory_order_relaxed); }
+    bool isDirty(size_t row) const { return dirtyFlags[row].value.load(std::memory_order_relaxed) != 0; }
+    // A recency stamp for readers that only hold Bank's shard lock shared;
+    // takeUsed reads and clears it when the LRU list is next reordered. The
+    // load first keeps hot rows from writing the cache line every time.
+    void markUsed(size_t row) {
+        if (usedFlags[row].value.load(std::memory_order_relaxed) == 0) {
+            usedFlags[row].value.store(1, std::memory_order_relaxed);
+        }
+    }
+    bool takeUsed(size_t row) { return usedFlags[row].value.exchange(0, std::memory_order_relaxed) != 0; }
+    uint8_t type(size_t row) const { return types[row]; }
+    int64_t overdraftLimitCents(size_t row) const { return overdraftLimits[row]; }
+    bool isLocked(size_t row) const { return lockedFlags[row].value.load(std::memory_order_relaxed) != 0; }
+    void setLocked(size_t row, bool locked) { lockedFlags[row].value.store(locked ? 1 : 0, std::memory_order_relaxed); }
+    int failedAttempts(size_t row) const { return failedAttemptCounts[row].value.load(std::memory_order_relaxed); }
+    void setFailedAttempts(size_t row, int attempts) {
+        failedAttemptCounts[row].value.store(attempts, std::memory_order_relaxed);
+    }
+    uint32_t card(size_t row) const { return cards[row]; }
+    const std::string& accountNumber(size_t row) const { return accountNumbers[row]; }
+    const std::string& pin(size_t row) const { return pins[row]; }
+    void setPin(size_t row, const std::string& pin) { pins[row] = pin; }
+    const std::string& holderName(size_t row) const { return holderNames[row]; }
+
+    // Transactions kept in memory per account, set before rows are added;
+    // 0 keeps none.
+    size_t getHistoryCapacity() const { return historyCapacity; }
+    void setHistoryCapacity(size_t capacity) { historyCapacity = std::min<size_t>(capacity, UINT32_MAX); }
+
+    void addHistory(size_t row, const Transaction& trans) {
+        History& history = histories[row];
+        ++history.added;
+        if (history.entries.size() < historyCapacity && history.next == 0) {
+            if (history.entries.empty()) history.entries.reserve(historyCapacity);
+            history.entries.push_back(trans);
+            return;
+        }
+        if (history.entries.empty()) return;
+        history.entries[history.next] = trans;
+        history.next = static_cast<uint32_t>((history.next + 1) % history.entries.size());
+    }
+
+    // The transactions held in memory, oldest first.
+    std::vector<Transaction> recentHistory(size_t row) const {
+        const History& history = histories[row];
+        std::vector<Transaction> recent;
+        recent.reserve(history.entries.size());
+        recent.insert(recent.end(), history.entries.begin() + history.next, history.entries.end());
+        recent.insert(recent.end(), history.entries.begin(), history.entries.begin() + history.next);
+        return recent;
+    }
+
+    size_t historySize(size_t row) const { return histories[row].entries.size(); }
+    // Transactions added since the row was loaded, including ones the ring
+    // has since dropped.
+    uint64_t historyAdded(size_t row) const { return histories[row].added; }
+    // Heap bytes held by the row's ring.
+    size_t historyBytes(size_t row) const { return histories[row].entries.capacity() * sizeof(Transaction); }
+
+    // The live view of a row, if anyone outside the table still holds one.
+    std::shared_ptr<Account> cachedView(size_t row) const { return views[row].lock(); }
+    bool hasView(size_t row) const { return !views[row].expired(); }
+    void cacheView(size_t row, const std::shared_ptr<Account>& view) { views[row] = view; }
+};
+
+#endif // ACCOUNTTABLE_H
@@ -22,20 +22,17 @@ public:
     
 
     void addInterest(Bank& bank, double rate) {
-        for (auto const& [key, accPtr] : bank.getAllAccounts()) {
-            if (accPtr->displayAccountType() == "Savings Account") {
-                accPtr->applyInterest(rate);
-            }
-        }
+        bank.runEndOfDay(rate, 0.0);
+    }
+
+    // Interest on every savings account and the overdraft fee on every
+    // checking account below zero, committed together.
+    Bank::EndOfDayStats runEndOfDay(Bank& bank, double rate, double overdraftFee = CheckingAccount::DEFAULT_OVERDRAFT_FEE) {
+        return bank.runEndOfDay(rate, overdraftFee);
     }
 
     bool resetPIN(Bank& bank, const std::string& accountNumber, const std::string& newPIN) {
-        auto account = bank.getAccount(accountNumber);
-        if (account) {
-            account->setPin(newPIN);
-            return true;
-        }
-        return false;
+        return bank.changePin(accountNumber, newPIN);
     }
     bool unlockCard(Bank& bank, const std::string& accountNumber) {
         return bank.setAccountLock(accountNumber, false);
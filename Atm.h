@@ -4,15 +4,17 @@
 #include <string>
 #include "Bank.h"
 #include "Card.h"
+#include "TransactionIdGenerator.h"
 
 class ATM {
 private:
     Bank& bank;
     double cashAvailable;
-    int transactionCounter;
+    TransactionIdGenerator transactionIds;
 
 public:
-    ATM(Bank& bankRef) : bank(bankRef), cashAvailable(1000000.0), transactionCounter(0) {}
+    // ATMs sharing a bank need distinct ids (0 to TransactionIdGenerator::BATCH_NODE - 1).
+    ATM(Bank& bankRef, uint32_t atmId = 0) : bank(bankRef), cashAvailable(1000000.0), transactionIds(atmId) {}
 
     void refillCash(double amount) {
         if (amount > 0) {
@@ -46,8 +48,8 @@ public:
         return bank;
     }
 
-    std::string generateTransactionID() {
-        return "TXN" + std::to_string(++transactionCounter);
+    uint64_t generateTransactionID() {
+        return transactionIds.next();
     }
 };
 
@@ -3,8 +3,7 @@
 #include <iomanip>
 #include <iostream>
 #include <cctype>
-#include <chrono>
-#include <ctime>
+#include <algorithm>
 
 using namespace std;
 
@@ -27,25 +26,11 @@ static bool isValidNumber(const string& str) {
     
     return hasDigit; // Must have at least one digit
 }
-//shows just the timestamp in the receipts
-static std::string currentTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    std::time_t t = std::chrono::system_clock::to_time_t(now);
-    std::tm tm{};
-#if defined(_WIN32) || defined(_WIN64)
-    localtime_s(&tm, &t);
-#else
-    localtime_r(&t, &tm);
-#endif
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-    return oss.str();
-}
 
-ATMInterface::ATMInterface()
+ATMInterface::ATMInterface(uint32_t atmId, bool printStats)
     : window(sf::VideoMode(900, 650), "ATM Simulator - Project Group 32"),
       bank(),
-      atmMachine(bank),
+      atmMachine(bank, atmId),
       admin(),
       currentState(STATE_WELCOME),
       currentAccount(nullptr),
@@ -54,8 +39,15 @@ ATMInterface::ATMInterface()
       transactionPage(0),
       transactionPageSize(4),
       adminActionMode(ADMIN_ACTION_NONE),
-      previousMenuState(STATE_MAIN_MENU) {
+      previousMenuState(STATE_MAIN_MENU),
+      printStats(printStats) {
     
+    if (printStats) {
+        const Bank::LoadStats& loadStats = bank.getLoadStats();
+        cout << "Loaded " << loadStats.records << " account records in " << fixed << setprecision(3)
+             << loadStats.seconds << "s (" << setprecision(1) << loadStats.megabytesPerSecond() << " MB/s)" << endl;
+    }
+
     window.setFramerateLimit(60);
     window.requestFocus();
     
@@ -120,6 +112,22 @@ void ATMInterface::run() {
             updateInsertCard(dt);
         }
         render();
+        bank.flushIfDue();
+    }
+    bank.flush();
+    TransactionLog::flush();
+
+    if (!printStats) return;
+    std::vector<Bank::HistoryUsage> historyUsage = bank.getHistoryUsage();
+    if (!historyUsage.empty()) {
+        size_t totalBytes = 0;
+        cout << "In-memory transaction history:" << endl;
+        for (const Bank::HistoryUsage& usage : historyUsage) {
+            cout << "  " << usage.accountNumber << ": " << usage.entries << "/" << usage.capacity
+                 << " kept of " << usage.added << ", " << usage.bytes << " bytes" << endl;
+            totalBytes += usage.bytes;
+        }
+        cout << "  total " << totalBytes << " bytes for " << historyUsage.size() << " accounts" << endl;
     }
 }
 
@@ -150,7 +158,7 @@ void ATMInterface::handleEvents() {
                 currentState == STATE_ADMIN_LOGIN || currentState == STATE_TRANSFER ||
                 currentState == STATE_TRANSFER_AMOUNT || currentState == STATE_CHANGE_PIN_CURRENT ||
                 currentState == STATE_CHANGE_PIN_NEW || currentState == STATE_CHANGE_PIN_CONFIRM ||
-                currentState == STATE_ADMIN_ADD_INTEREST) {
+                currentState == STATE_ADMIN_ADD_INTEREST || currentState == STATE_ADMIN_VIEW_ALL_TRANSACTIONS) {
                 handleTextInput(event.text.unicode);
             }
         }
@@ -245,6 +253,13 @@ void ATMInterface::handleTextInput(sf::Uint32 unicode) {
             }
         } else if (currentState == STATE_CHANGE_PIN_CONFIRM) {
             processPinChange();
+        } else if (currentState == STATE_ADMIN_VIEW_ALL_TRANSACTIONS) {
+            if (!currentInput.empty()) {
+                size_t target = stoul(currentInput);
+                transactionCursor.page(target > 0 ? target - 1 : 0);
+                transactionPage = (int)transactionCursor.pageIndex();
+                currentInput.clear();
+            }
         }
     } else if (unicode == '.' && (currentState == STATE_WITHDRAW || currentState == STATE_DEPOSIT ||
                                   currentState == STATE_TRANSFER || currentState == STATE_TRANSFER_AMOUNT ||
@@ -267,6 +282,8 @@ void ATMInterface::handleTextInput(sf::Uint32 unicode) {
             currentInput += static_cast<char>(unicode);
         } else if (isAmountState && currentInput.length() < 30) {
             currentInput += static_cast<char>(unicode);
+        } else if (currentState == STATE_ADMIN_VIEW_ALL_TRANSACTIONS && currentInput.length() < 9) {
+            currentInput += static_cast<char>(unicode);
         }
     } else if ((unicode >= 65 && unicode <= 90) || (unicode >= 97 && unicode <= 122) || unicode == 32) { // Letters and space
         if (currentState == STATE_ENTER_NAME && currentInput.length() < 50) {
@@ -405,6 +422,7 @@ void ATMInterface::checkCardNumber() {
     
     cardNumberInput = currentInput;
     currentInput.clear();
+    transactionMessage.clear();
     
     if (bank.accountExists(cardNumberInput)) {
         // Check if card is locked
@@ -446,42 +464,42 @@ void ATMInterface::enterPIN(const string& pin) {
             currentInput.clear();
             return;
         }
-        if (bank.isAccountLocked(currentCard->getAccountNumber())) {
+        const string accountNumber = currentCard->getAccountNumber();
+        if (!bank.accountExists(accountNumber)) {
+            // Deleted since the card was read; start over with another one.
+            transactionMessage = "This card is no longer registered.\nPlease enter your card number again.";
+            currentInput.clear();
+            currentCard.reset();
+            setScreen(STATE_CARD_INPUT);
+            return;
+        }
+        if (bank.isAccountLocked(accountNumber)) {
             transactionMessage = "This card is locked.\nPlease contact an administrator to unlock it.";
             currentInput.clear();
             setScreen(STATE_TRANSACTION_COMPLETE);
             return;
         }
 
-        if (bank.verifyPIN(currentCard->getAccountNumber(), pin)) {
-            // Get account and reset failed attempts on successful login
-            currentAccount = bank.getAccount(currentCard->getAccountNumber());
-            if (currentAccount) {
-                currentAccount->resetFailedAttempts();
-                bank.updateAccountData();
-            }
+        if (bank.verifyPIN(accountNumber, pin)) {
+            // Reset failed attempts on successful login
+            currentAccount = bank.getAccount(accountNumber);
+            bank.resetFailedAttempts(accountNumber);
             currentInput.clear();
             setScreen(STATE_MAIN_MENU);
         } else {
-            // Wrong PIN - increment failed attempts
-            auto account = bank.getAccount(currentCard->getAccountNumber());
-            if (account) {
-                account->incrementFailedAttempts();
-                int attempts = account->getFailedLoginAttempts();
-                
-                // Lock card after 3 failed attempts
-                if (attempts >= 3) {
-                    account->lockCard();
-                    bank.updateAccountData();
-                    transactionMessage = "Invalid PIN!\nCard locked due to 3 failed PIN attempts.\nPlease contact an administrator.";
-                    currentInput.clear();
-                    setScreen(STATE_TRANSACTION_COMPLETE);
-                } else {
-                    // Show remaining attempts
-                    int attemptsLeft = 3 - attempts;
-                    transactionMessage = "Invalid PIN!\n" + to_string(attemptsLeft) + " attempt(s) remaining before card is locked.";
-                    currentInput.clear();
-                }
+            // Wrong PIN - the bank counts it and locks the card at the limit
+            int attempts = bank.recordFailedPin(accountNumber);
+            
+            if (attempts >= Bank::maxPinAttempts) {
+                transactionMessage = "Invalid PIN!\nCard locked due to " + to_string(Bank::maxPinAttempts) +
+                                     " failed PIN attempts.\nPlease contact an administrator.";
+                currentInput.clear();
+                setScreen(STATE_TRANSACTION_COMPLETE);
+            } else {
+                // Show remaining attempts
+                int attemptsLeft = Bank::maxPinAttempts - attempts;
+                transactionMessage = "Invalid PIN!\n" + to_string(attemptsLeft) + " attempt(s) remaining before card is locked.";
+                currentInput.clear();
             }
         }
     }
@@ -493,28 +511,27 @@ void ATMInterface::processWithdrawal(const string& amountStr) {
         double amount = stod(amountStr);
         
         if (currentAccount && atmMachine.canDispense(amount)) {
-            if (currentAccount->withdraw(amount)) {
+            if (bank.withdraw(currentAccount->getAccountNumber(), amount)) {
                 atmMachine.dispenseCash(amount);
-                bank.updateAccountData();
                 
-                auto trans = make_shared<WithdrawalTransaction>(
+                WithdrawalTransaction trans(
                     atmMachine.generateTransactionID(),
                     currentAccount->getAccountNumber(),
                     amount
                 );
-                currentAccount->addTransaction(trans);
-                TransactionLog::logTransaction(trans, "WITHDRAWAL");
+                bank.recordHistory(currentAccount->getAccountNumber(), trans);
+                TransactionLog::logTransaction(trans);
                 
                 stringstream ss;
                 //trans here is sending this withdrawl to transactionlog.h to store the transaction in printreceipt
                 ss << "Withdrawal Successful!\n\n";
-                ss << trans->printReceipt();
+                ss << trans.printReceipt();
                 ss << "\nRemaining Balance: $" << fixed << setprecision(2) 
                    << currentAccount->getBalance();
                 
                 transactionMessage = ss.str();
                 currentInput.clear();
-                setScreen(STATE_caCOMPLETE);
+                setScreen(STATE_TRANSACTION_COMPLETE);
             } else {
                 transactionMessage = "Insufficient funds!";
                 currentInput.clear();
@@ -537,7 +554,7 @@ void ATMInterface::processDeposit(const string& amountStr) {
         
         if (currentAccount && amount > 0) {
             if (amount > 7500.0) {
-                std::string reqId = bank.addPendingDeposit(currentAccount->getAccountNumber(), amount, currentTimestamp());
+                std::string reqId = bank.addPendingDeposit(currentAccount->getAccountNumber(), amount, TimeFormat::now());
                 atmMachine.acceptCash(amount);
 
                 stringstream ss;
@@ -550,22 +567,21 @@ void ATMInterface::processDeposit(const string& amountStr) {
                 return;
             }
 
-            currentAccount->deposit(amount);
+            bank.deposit(currentAccount->getAccountNumber(), amount);
             atmMachine.acceptCash(amount);
-            bank.updateAccountData();
             
-            auto trans = make_shared<DepositTransaction>(
+            DepositTransaction trans(
                 atmMachine.generateTransactionID(),
                 currentAccount->getAccountNumber(),
                 amount
             );
-            currentAccount->addTransaction(trans);
-            TransactionLog::logTransaction(trans, "DEPOSIT");
+            bank.recordHistory(currentAccount->getAccountNumber(), trans);
+            TransactionLog::logTransaction(trans);
             
             //similar to withdrawl, store in transactionlog.h and print
             stringstream ss;
             ss << "Deposit Successful!\n\n";
-            ss << trans->printReceipt();
+            ss << trans.printReceipt();
             ss << "\nNew Balance: $" << fixed << setprecision(2) 
                << currentAccount->getBalance();
             
@@ -587,58 +603,48 @@ void ATMInterface::processTransfer(const string& amountStr) {
         double amount = stod(amountStr);
         
         if (currentAccount && amount > 0) {
-            // Check if recipient account exists
-            if (!bank.accountExists(transferRecipientAccount)) {
-                transactionMessage = "Recipient account not found!";
-                currentInput.clear();
-                setScreen(STATE_TRANSACTION_COMPLETE);
-                return;
-            }
-            
-            // Check if recipient account is locked
-            if (bank.isAccountLocked(transferRecipientAccount)) {
-                transactionMessage = "Cannot transfer to a locked account!\nRecipient account is temporarily locked.";
-                currentInput.clear();
-                setScreen(STATE_TRANSACTION_COMPLETE);
-                return;
-            }
-            
-            // Check if sender has sufficient funds
-            if (currentAccount->getBalance() < amount) {
-                transactionMessage = "Insufficient funds for transfer!";
+            // Checks and both balance updates happen atomically inside the bank
+            Bank::TransferResult result = bank.transfer(currentAccount->getAccountNumber(), transferRecipientAccount, amount);
+            if (result != Bank::TransferResult::Ok) {
+                switch (result) {
+                case Bank::TransferResult::InvalidAmount:
+                    transactionMessage = "Invalid transfer amount!";
+                    break;
+                case Bank::TransferResult::SameAccount:
+                    transactionMessage = "Cannot transfer to your own account!";
+                    break;
+                case Bank::TransferResult::UnknownSender:
+                    transactionMessage = "Your account could not be found!\nPlease sign in again.";
+                    break;
+                case Bank::TransferResult::UnknownRecipient:
+                    transactionMessage = "Recipient account not found!";
+                    break;
+                case Bank::TransferResult::SenderLocked:
+                    transactionMessage = "Your card is locked!\nTransfers are not allowed.";
+                    break;
+                case Bank::TransferResult::RecipientLocked:
+                    transactionMessage = "Cannot transfer to a locked account!\nRecipient account is temporarily locked.";
+                    break;
+                case Bank::TransferResult::InsufficientFunds:
+                    transactionMessage = "Insufficient funds for transfer!";
+                    break;
+                case Bank::TransferResult::Ok:
+                    break;
+                }
                 currentInput.clear();
                 setScreen(STATE_TRANSACTION_COMPLETE);
                 return;
             }
-            
-            // Perform transfer
-            currentAccount->withdraw(amount);
-            auto recipientAcc = bank.getAccount(transferRecipientAccount);
-            if (recipientAcc) {
-                recipientAcc->deposit(amount);
-            }
-            
-            bank.updateAccountData();
-            
-            // Log transaction for sender (withdrawal)
-            auto trans = make_shared<WithdrawalTransaction>(
+            // One record carries both legs, so the log never holds half a transfer
+            TransferTransaction trans(
                 atmMachine.generateTransactionID(),
                 currentAccount->getAccountNumber(),
-                amount
-            );
-            currentAccount->addTransaction(trans);
-            TransactionLog::logTransaction(trans, "TRANSFER_OUT");
-            
-            // Log transaction for recipient (deposit)
-            auto recipientTrans = make_shared<DepositTransaction>(
-                atmMachine.generateTransactionID(),
                 transferRecipientAccount,
                 amount
             );
-            if (recipientAcc) {
-                recipientAcc->addTransaction(recipientTrans);
-            }
-            TransactionLog::logTransaction(recipientTrans, "TRANSFER_IN");
+            bank.recordHistory(currentAccount->getAccountNumber(), trans);
+            bank.recordHistory(transferRecipientAccount, trans);
+            TransactionLog::logTransaction(trans);
             
             stringstream ss;
             ss << "Transfer Successful!\n\n";
@@ -676,6 +682,7 @@ void ATMInterface::drawWelcomeScreen() {
     screenButtons.back().setAction([this]() {
         currentInput.clear();
         cardNumberInput.clear();
+        transactionMessage.clear();
         setScreen(STATE_INSERT_CARD);
     });
     
@@ -704,6 +711,17 @@ void ATMInterface::drawCardInputScreen() {
     inputText.setPosition(350, 250);
     window.draw(inputText);
     
+    // Why the last card number was turned away, if it was
+    if (!transactionMessage.empty()) {
+        sf::Text messageText;
+        messageText.setFont(mainFont);
+        messageText.setCharacterSize(16);
+        messageText.setFillColor(sf::Color::Red);
+        messageText.setString(transactionMessage);
+        messageText.setPosition(150, 300);
+        window.draw(messageText);
+    }
+    
     screenButtons.emplace_back("Continue", mainFont, sf::Vector2f(200, 50), sf::Vector2f(200, 370));
     screenButtons.back().setAction([this]() { checkCardNumber(); });
     
@@ -953,7 +971,7 @@ void ATMInterface::drawMainMenu() {
     screenButtons.emplace_back("Transactions", mainFont, sf::Vector2f(btnWidth, btnHeight), sf::Vector2f(col1X, row2Y));
     screenButtons.back().setAction([this]() { 
         transactionPage = 0;
-        currentTransactions = TransactionLog::readTransactions(currentAccount->getAccountNumber());
+        transactionCursor = TransactionLog::newestFirst(currentAccount->getAccountNumber(), transactionPageSize);
         setScreen(STATE_VIEW_TRANSACTIONS); 
     });
     
@@ -1135,7 +1153,8 @@ void ATMInterface::drawAdminMenu() {
     screenButtons.emplace_back("View Transactions", mainFont, sf::Vector2f(btnWidth, btnHeight), sf::Vector2f(col2X, row1Y));
     screenButtons.back().setAction([this]() {
         transactionPage = 0;
-        currentTransactions = TransactionLog::readTransactions();
+        transactionCursor = TransactionLog::newestFirst("", transactionPageSize);
+        currentInput.clear();
         setScreen(STATE_ADMIN_VIEW_ALL_TRANSACTIONS);
     });
 
@@ -1185,11 +1204,15 @@ void ATMInterface::drawAdminViewAccounts() {
     displayText.setPosition(180, 130);
     window.draw(displayText);
     
-    auto& accounts = bank.getAllAccounts();
     int yPos = 170 - scrollOffset;
     
-    for (auto const& [key, accPtr] : accounts) {
-        if (yPos > 120 && yPos < 560) {
+    // Rows past the bottom of the window are never drawn, so stop there
+    // instead of walking (and in lazy mode paging in) every account.
+    bank.forEachAccount([&](const shared_ptr<Account>& accPtr) {
+        if (yPos >= 560) {
+            return false;
+        }
+        if (yPos > 120) {
             sf::Text accText;
             accText.setFont(mainFont);
             accText.setCharacterSize(13);
@@ -1200,14 +1223,15 @@ void ATMInterface::drawAdminViewAccounts() {
             ss << "Card: " << accPtr->getAccountNumber() << " | ";
             ss << "Type: " << accPtr->displayAccountType() << " | ";
             ss << "Balance: $" << fixed << setprecision(2) << accPtr->getBalance() << " | ";
-            ss << (bank.isAccountLocked(accPtr->getAccountNumber()) ? "Status: LOCKED" : "Status: Active");
+            ss << (accPtr->getIsLocked() ? "Status: LOCKED" : "Status: Active");
             
             accText.setString(ss.str());
             accText.setPosition(140, yPos);
             window.draw(accText);
         }
         yPos += 40;
-    }
+        return true;
+    });
     
     screenButtons.emplace_back("Back", mainFont, sf::Vector2f(150, 45), sf::Vector2f(325, 540));
     screenButtons.back().setAction([this]() { setScreen(STATE_ADMIN_MENU); });
@@ -1223,16 +1247,15 @@ void ATMInterface::drawAdminSelectAccount() {
     displayText.setPosition(200, 140);
     window.draw(displayText);
     
-    auto& accounts = bank.getAllAccounts();
     float col1X = 170, col2X = 340, col3X = 510;
     float row1Y = 210, row2Y = 280;
     float btnWidth = 150, btnHeight = 45;
     int count = 0;
     
-    for (auto const& [key, accPtr] : accounts) {
+    bank.forEachAccount([&](const shared_ptr<Account>& accPtr) {
         if (count < 6) {
             string label = accPtr->getAccountNumber().substr(0, 7);
-            if (bank.isAccountLocked(accPtr->getAccountNumber())) {
+            if (accPtr->getIsLocked()) {
                 label += " (Locked)";
             }
             float xPos, yPos;
@@ -1251,7 +1274,6 @@ void ATMInterface::drawAdminSelectAccount() {
                 switch (adminActionMode) {
                     case ADMIN_ACTION_RESET_PIN:
                         if (admin.resetPIN(bank, accNum, "0000")) {
-                            bank.updateAccountData();
                             transactionMessage = "PIN reset to 0000 for account:\n" + accNum;
                         } else {
                             transactionMessage = "Unable to reset PIN for account:\n" + accNum;
@@ -1276,7 +1298,8 @@ void ATMInterface::drawAdminSelectAccount() {
             });
             count++;
         }
-    }
+        return count < 6;
+    });
     
     screenButtons.emplace_back("Back", mainFont, sf::Vector2f(150, 45), sf::Vector2f(325, 360));
     screenButtons.back().setAction([this]() { 
@@ -1297,7 +1320,7 @@ void ATMInterface::drawAdminAddInterestScreen() {
 
     displayText.setCharacterSize(18);
     displayText.setFillColor(sf::Color::White);
-    displayText.setString("Enter interest percentage then pick a Savings account:");
+    displayText.setString("Enter interest percentage, then pick an account or End of Day:");
     displayText.setPosition(120, 200);
     window.draw(displayText);
 
@@ -1312,11 +1335,12 @@ void ATMInterface::drawAdminAddInterestScreen() {
     //using shared pointer so we dont have to manually dealloacate 
 
     std::vector<std::shared_ptr<Account>> savings;
-    for (auto const& [key, accPtr] : bank.getAllAccounts()) {
+    bank.forEachAccount([&savings](const std::shared_ptr<Account>& accPtr) {
         if (accPtr && accPtr->displayAccountType() == "Savings Account") {
             savings.push_back(accPtr);
         }
-    }
+        return savings.size() < 6; // only six buttons fit
+    });
 
     if (savings.empty()) {
         displayText.setCharacterSize(20);
@@ -1349,10 +1373,7 @@ void ATMInterface::drawAdminAddInterestScreen() {
                     return;
                 }
                 double rate = percent / 100.0;
-                auto acc = bank.getAccount(accNum);
-                if (acc && acc->displayAccountType() == "Savings Account") {
-                    acc->applyInterest(rate);
-                    bank.updateAccountData();
+                if (bank.applyInterest(accNum, rate)) {
                     stringstream ss;
                     ss << "Added " << fixed << setprecision(2) << percent << "% interest\n"
                        << "to savings account " << accNum;
@@ -1367,6 +1388,27 @@ void ATMInterface::drawAdminAddInterestScreen() {
         }
     }
 
+    // Interest on every savings account plus overdraft fees, in one run
+    screenButtons.emplace_back("End of Day", mainFont, sf::Vector2f(160, 45), sf::Vector2f(150, 470));
+    screenButtons.back().setAction([this]() {
+        if (currentInput.empty() || !isValidNumber(currentInput) || stod(currentInput) < 0) {
+            transactionMessage = "Enter a valid percentage.";
+            previousMenuState = STATE_ADMIN_MENU;
+            setScreen(STATE_TRANSACTION_COMPLETE);
+            return;
+        }
+        double percent = stod(currentInput);
+        Bank::EndOfDayStats stats = admin.runEndOfDay(bank, percent / 100.0);
+        stringstream ss;
+        ss << "End of day: " << fixed << setprecision(2) << percent << "% interest\n"
+           << stats.interestCredited << " savings accounts credited $" << stats.interestPaid << "\n"
+           << stats.feesCharged << " overdraft fees charged $" << stats.feesCollected;
+        transactionMessage = ss.str();
+        currentInput.clear();
+        previousMenuState = STATE_ADMIN_MENU;
+        setScreen(STATE_TRANSACTION_COMPLETE);
+    });
+
     screenButtons.emplace_back("Cancel", mainFont, sf::Vector2f(160, 45), sf::Vector2f(320, 470));
     screenButtons.back().setAction([this]() {
         currentInput.clear();
@@ -1405,7 +1447,7 @@ void ATMInterface::drawAdminPendingDeposits() {
             stringstream ss;
             ss << pd.id << " | Acc: " << pd.accountNumber
                << " | Amount: $" << fixed << setprecision(2) << pd.amount
-               << " | " << pd.timestamp;
+               << " | " << pd.timestamp();
             row.setString(ss.str());
             row.setPosition(80, yPos);
             window.draw(row);
@@ -1415,17 +1457,14 @@ void ATMInterface::drawAdminPendingDeposits() {
             screenButtons.back().setAction([this, reqId]() {
                 Bank::PendingDeposit pdOut;
                 if (bank.takePendingDeposit(reqId, pdOut)) {
-                    auto acc = bank.getAccount(pdOut.accountNumber);
-                    if (acc) {
-                        acc->deposit(pdOut.amount);
-                        bank.updateAccountData();
-                        auto trans = make_shared<DepositTransaction>(
+                    if (bank.deposit(pdOut.accountNumber, pdOut.amount)) {
+                        DepositTransaction trans(
                             atmMachine.generateTransactionID(),
                             pdOut.accountNumber,
                             pdOut.amount
                         );
-                        acc->addTransaction(trans);
-                        TransactionLog::logTransaction(trans, "DEPOSIT");
+                        bank.recordHistory(pdOut.accountNumber, trans);
+                        TransactionLog::logTransaction(trans);
                         stringstream ss;
                         ss << "Approved deposit $" << fixed << setprecision(2) << pdOut.amount
                            << " for account " << pdOut.accountNumber;
@@ -1459,21 +1498,18 @@ void ATMInterface::drawViewTransactionsScreen() {
     displayText.setPosition(200, 120);
     window.draw(displayText);
     
-    if (currentTransactions.empty()) {
+    const std::vector<TransactionRecord>& pageRecords = transactionCursor.page(transactionPage);
+    if (pageRecords.empty()) {
         displayText.setCharacterSize(20);
         displayText.setFillColor(sf::Color::Yellow);
         displayText.setString("No transactions found");
         displayText.setPosition(300, 300);
         window.draw(displayText);
     } else {
-        int startIdx = transactionPage * transactionPageSize;
-        int endIdx = min(startIdx + transactionPageSize, (int)currentTransactions.size());
-        
         int yPos = 160;
-        for (int i = startIdx; i < endIdx; i++) {
-            auto& trans = currentTransactions[i];
+        for (const auto& trans : pageRecords) {
             stringstream ss;
-            ss << "[" << trans.type << "] $" << fixed << setprecision(2) << trans.amount;
+            ss << "[" << trans.typeName() << "] $" << fixed << setprecision(2) << trans.amount();
             
             displayText.setCharacterSize(15);
             displayText.setFillColor(sf::Color::Green);
@@ -1483,7 +1519,7 @@ void ATMInterface::drawViewTransactionsScreen() {
             
             displayText.setCharacterSize(13);
             displayText.setFillColor(sf::Color::Cyan);
-            displayText.setString(trans.timestamp);
+            displayText.setString(trans.timestamp());
             displayText.setPosition(140, yPos + 20);
             window.draw(displayText);
             
@@ -1494,8 +1530,7 @@ void ATMInterface::drawViewTransactionsScreen() {
         displayText.setCharacterSize(14);
         displayText.setFillColor(sf::Color::Magenta);
         stringstream pageInfo;
-        pageInfo << "Page " << (transactionPage + 1) << " of " 
-                 << ((currentTransactions.size() + transactionPageSize - 1) / transactionPageSize);
+        pageInfo << "Page " << (transactionPage + 1);
         displayText.setString(pageInfo.str());
         displayText.setPosition(350, 475);
         window.draw(displayText);
@@ -1510,7 +1545,7 @@ void ATMInterface::drawViewTransactionsScreen() {
         screenButtons.back().setAction([this]() { transactionPage--; });
     }
     
-    if ((transactionPage + 1) * transactionPageSize < (int)currentTransactions.size()) {
+    if (transactionCursor.hasPage(transactionPage + 1)) {
         screenButtons.emplace_back("Next", mainFont, sf::Vector2f(140, 50), sf::Vector2f(600, buttonY));
         screenButtons.back().setAction([this]() { transactionPage++; });
     }
@@ -1526,22 +1561,22 @@ void ATMInterface::drawAdminViewAllTransactionsScreen() {
     displayText.setPosition(220, 120);
     window.draw(displayText);
     
-    if (currentTransactions.empty()) {
+    const std::vector<TransactionRecord>& pageRecords = transactionCursor.page(transactionPage);
+    if (pageRecords.empty()) {
         displayText.setCharacterSize(20);
         displayText.setFillColor(sf::Color::Yellow);
         displayText.setString("No transactions found");
         displayText.setPosition(300, 300);
         window.draw(displayText);
     } else {
-        int startIdx = transactionPage * transactionPageSize;
-        int endIdx = min(startIdx + transactionPageSize, (int)currentTransactions.size());
-        
         int yPos = 160;
-        for (int i = startIdx; i < endIdx; i++) {
-            auto& trans = currentTransactions[i];
+        for (const auto& trans : pageRecords) {
             stringstream ss;
-            ss << "[" << trans.type << "] " << trans.accountNumber.substr(0, 6) << "... - $" 
-               << fixed << setprecision(2) << trans.amount;
+            ss << "[" << trans.typeName() << "] " << trans.accountNumber().substr(0, 6) << "... ";
+            if (trans.type == TransactionSegment::TYPE_TRANSFER) {
+                ss << "-> " << trans.counterpartyNumber().substr(0, 6) << "... ";
+            }
+            ss << "- $" << fixed << setprecision(2) << trans.amount();
             
             displayText.setCharacterSize(14);
             displayText.setFillColor(sf::Color::White);
@@ -1551,7 +1586,7 @@ void ATMInterface::drawAdminViewAllTransactionsScreen() {
             
             displayText.setCharacterSize(12);
             displayText.setFillColor(sf::Color::Cyan);
-            displayText.setString(trans.timestamp);
+            displayText.setString(trans.timestamp());
             displayText.setPosition(140, yPos + 20);
             window.draw(displayText);
             
@@ -1562,23 +1597,31 @@ void ATMInterface::drawAdminViewAllTransactionsScreen() {
         displayText.setCharacterSize(13);
         displayText.setFillColor(sf::Color::Magenta);
         stringstream pageInfo;
-        pageInfo << "Page " << (transactionPage + 1) << " of " 
-                 << ((currentTransactions.size() + transactionPageSize - 1) / transactionPageSize);
+        pageInfo << "Page " << (transactionPage + 1) << " of " << transactionCursor.pageCount();
         displayText.setString(pageInfo.str());
         displayText.setPosition(350, 475);
         window.draw(displayText);
+
+        // Typed page number, jumped to on Enter
+        displayText.setFillColor(sf::Color::White);
+        displayText.setString("Go to page: " + currentInput + "_");
+        displayText.setPosition(520, 475);
+        window.draw(displayText);
     }
     
     float buttonY = 500;
     screenButtons.emplace_back("Back", mainFont, sf::Vector2f(140, 50), sf::Vector2f(120, buttonY));
-    screenButtons.back().setAction([this]() { setScreen(STATE_ADMIN_MENU); });
+    screenButtons.back().setAction([this]() {
+        currentInput.clear();
+        setScreen(STATE_ADMIN_MENU);
+    });
     
     if (transactionPage > 0) {
         screenButtons.emplace_back("Prev", mainFont, sf::Vector2f(140, 50), sf::Vector2f(360, buttonY));
         screenButtons.back().setAction([this]() { transactionPage--; });
     }
     
-    if ((transactionPage + 1) * transactionPageSize < (int)currentTransactions.size()) {
+    if (transactionCursor.hasPage(transactionPage + 1)) {
         screenButtons.emplace_back("Next", mainFont, sf::Vector2f(140, 50), sf::Vector2f(600, buttonY));
         screenButtons.back().setAction([this]() { transactionPage++; });
     }
@@ -1719,11 +1762,18 @@ void ATMInterface::drawViewLockedCardsScreen() {
     window.draw(displayText);
     
     // Get all accounts and find locked ones
-    const auto& accountsMap = bank.getAllAccounts();
     vector<shared_ptr<Account>> lockedAccounts;
     
-    for (const auto& [key, acc] : accountsMap) {
-        if (acc && acc->getIsLocked()) {
+    // Scan the lock flag column and only build accounts for locked cards
+    vector<string> lockedCards;
+    bank.forEachRow([&lockedCards](const AccountTable& table, size_t row) {
+        if (table.isLocked(row)) {
+            lockedCards.push_back(table.accountNumber(row));
+        }
+    });
+    sort(lockedCards.begin(), lockedCards.end());
+    for (const auto& card : lockedCards) {
+        if (auto acc = bank.getAccount(card)) {
             lockedAccounts.push_back(acc);
         }
     }
@@ -1961,8 +2011,7 @@ void ATMInterface::processPinChange() {
     }
     
     // Update PIN
-    currentAccount->setPin(newPinInput);
-    bank.updateAccountData();
+    bank.changePin(currentAccount->getAccountNumber(), newPinInput);
     
     transactionMessage = "PIN changed successfully!\nYour new PIN is now active.";
     currentInput.clear();
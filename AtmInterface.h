@@ -12,6 +12,7 @@
 #include "Transaction.h"
 #include "DepositTransaction.h"
 #include "WithdrawalTransaction.h"
+#include "TransferTransaction.h"
 #include "Admin.h"
 #include "Button.h"
 #include "TransactionLog.h"
@@ -84,13 +85,14 @@ private:
     
     std::vector<Button> screenButtons;
     int scrollOffset;
-    std::vector<TransactionRecord> currentTransactions;
+    TransactionLog::Cursor transactionCursor;
     int transactionPage;
     int transactionPageSize;
     std::string transferRecipientAccount;
     std::string currentPinInput;
     std::string newPinInput;
     ScreenState previousMenuState; // Track previous menu for transaction complete screen
+    bool printStats;
     
     enum AdminActionMode {
         ADMIN_ACTION_NONE,
@@ -153,7 +155,9 @@ private:
     std::string getAdminActionLabel() const;
 
 public:
-    ATMInterface();
+    // atmId tells apart the transaction ids of ATMs sharing a bank.
+    // printStats reports load time at start and in-memory history at exit.
+    explicit ATMInterface(uint32_t atmId = 0, bool printStats = false);
     void run();
 };
 
@@ -2,122 +2,1006 @@
 #define BANK_H
 
 #include <string>
-#include <map>
+#include <list>
 #include <algorithm>
 #include <memory>
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <iomanip>
+#include <cstdio>
+#include <cstdint>
+#include <set>
+#include <chrono>
+#include <string_view>
+#include <charconv>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
 #include "Account.h"
+#include "AccountJournal.h"
+#include "AccountRow.h"
+#include "AccountTable.h"
+#include "CardMap.h"
+#include "BinaryAccountStore.h"
+#include "MappedFile.h"
 #include "SavingsAccount.h"
+#include "TimeFormat.h"
 #include "CheckingAccount.h"
 
+// Every public member may be called from any thread. Accounts are split into
+// shards by card number, each with its own reader/writer lock. Balances
+// change through compare-and-swap (see AccountTable), so deposits,
+// withdrawals and transfers hold their shards shared and sessions hitting
+// the same account do not queue behind each other; paging, creating
+// accounts, commits and changes to anything but a balance take a shard
+// exclusively.
+//
+// Account views from getAccount and forEachAccount are the one thing used
+// outside a lock. A view stays valid for as long as it is held, whatever
+// other sessions do: table rows never move, and a viewed account is never
+// evicted. A view is for reading: its deposit and withdraw are atomic but
+// are not committed, so sessions change balances through deposit, withdraw
+// and transfer, and PINs, lock state, failed attempts, history and
+// interest through the Bank members named after them.
 class Bank {
 public:
     struct PendingDeposit {
         std::string id;
         std::string accountNumber;
         double amount;
-        std::string timestamp;
+        int64_t timestampMs{INT64_MIN}; // INT64_MIN if unknown
+
+        std::string timestamp() const { return timestampMs == INT64_MIN ? std::string() : TimeFormat::format(timestampMs); }
+    };
+
+    // Csv: text snapshot + journal. Binary: memory-mapped fixed-width records
+    // updated in place. Auto picks Binary when bank_accounts.bin exists.
+    enum class StorageFormat { Auto, Csv, Binary };
+
+    enum class TransferResult {
+        Ok,
+        InvalidAmount,
+        SameAccount,
+        UnknownSender,
+        UnknownRecipient,
+        SenderLocked,
+        RecipientLocked,
+        InsufficientFunds
+    };
+
+    // Wrong PINs in a row before recordFailedPin locks the card.
+    static constexpr int maxPinAttempts = 3;
+
+    // One line of a batch transfer file: from,to,amount.
+    struct TransferRequest {
+        std::string fromAccount;
+        std::string toAccount;
+        double amount{0.0};
+    };
+
+    struct LoadStats {
+        size_t bytes{0};
+        size_t records{0};
+        double seconds{0.0};
+
+        double megabytesPerSecond() const {
+            return seconds > 0.0 ? (static_cast<double>(bytes) / (1024.0 * 1024.0)) / seconds : 0.0;
+        }
+    };
+
+    // Mutations are grouped: dirty accounts are committed together once
+    // commitThreshold of them have accumulated or commitIntervalMs has passed
+    // since the last commit (0/1 commit every update synchronously).
+    struct Options {
+        StorageFormat format = StorageFormat::Auto;
+        size_t commitThreshold = 64;
+        long long commitIntervalMs = 200;
+        // Worker threads for parsing the snapshot at startup (0 = one per core).
+        unsigned loadThreads = 0;
+        // Lazy mode keeps only a card -> file location index in memory and
+        // pages accounts in on first access, evicting least recently used
+        // ones once the resident set exceeds memoryBudgetBytes.
+        bool lazyLoad = false;
+        size_t memoryBudgetBytes = 64 * 1024 * 1024;
+        // Independently locked partitions of the account set (rounded up to a
+        // power of two).
+        unsigned shardCount = 16;
+        // Transactions each resident account keeps in memory; older ones are
+        // read back from the transaction log.
+        size_t historyLength = AccountTable::DEFAULT_HISTORY_CAPACITY;
+    };
+
+    // Memory held by one account's in-memory transaction history.
+    struct HistoryUsage {
+        std::string accountNumber;
+        size_t entries{0};
+        size_t capacity{0};
+        uint64_t added{0};
+        size_t bytes{0};
+    };
+
+    // What an end-of-day run did.
+    struct EndOfDayStats {
+        size_t accounts{0};
+        size_t interestCredited{0};
+        double interestPaid{0.0};
+        size_t feesCharged{0};
+        double feesCollected{0.0};
+        // Sum of each shard's most resident accounts during the run.
+        size_t peakResidentAccounts{0};
+        double seconds{0.0};
     };
 
 private:
-    std::map<std::string, std::shared_ptr<Account>> accounts;
-    std::map<std::string, std::string> accountNames; 
-    const std::string dataFile = "bank_accounts.dat";
-    const std::string pendingFile = "pending_deposits.dat";
+    // Where the latest committed row of an account lives on disk: a byte
+    // offset into the snapshot or journal, or a record slot in the binary store.
+    struct RowLocation {
+        enum Source : uint8_t { SNAPSHOT, JOURNAL, STORE };
+        Source source;
+        uint64_t offset;
+    };
+
+    // One partition of the accounts, everything guarded by lock. Holders of
+    // the shared lock may read rows, change balances and mark rows dirty
+    // (under dirtyLock); all other changes need it exclusively. Resident
+    // accounts (all of them, unless lazy loading is on) live in a columnar
+    // table; rows maps a card to its table row. Everything is keyed by the
+    // integer card number (card numbers are 7 digits).
+    struct Shard {
+        std::shared_mutex lock;
+        AccountTable table;
+        CardMap<uint32_t> rows;
+        CardMap<RowLocation> locations;
+        std::mutex dirtyLock;
+        std::set<uint32_t> dirty;
+        // Taken out of dirty by a commit that has not reached disk yet.
+        std::set<uint32_t> committing;
+        std::list<uint32_t> lruOrder;
+        CardMap<std::list<uint32_t>::iterator> lruPos;
+        size_t residentBytes{0};
+    };
+
+    // Lock order: commitLock, orderLock, shard locks by ascending index,
+    // storageLock. pendingLock is never held together with another lock.
+    std::vector<Shard> shards;
+    unsigned shardShift{32};
+    std::mutex commitLock;
+    std::mutex orderLock;   // cardOrder
+    std::mutex storageLock; // journal, store, snapshotMap
+    std::mutex pendingLock; // pendingDeposits, pendingCounter
+
+    // All card numbers in ascending order, for forEachAccount; rebuilt when
+    // the card set changes (cardSetVersion).
+    std::shared_ptr<const std::vector<uint32_t>> cardOrder;
+    uint64_t cardOrderVersion{0};
+    std::atomic<uint64_t> cardSetVersion{1};
+
+    static inline const std::string dataFile = "bank_accounts.dat";
+    static inline const std::string journalFile = "bank_accounts.journal";
+    static inline const std::string binaryFile = "bank_accounts.bin";
+    static inline const std::string namesFile = "bank_accounts.names";
+    static inline const std::string pendingFile = "pending_deposits.dat";
+    static constexpr size_t minJournalRecords = 1024;
+    AccountJournal journal{journalFile};
+    StorageFormat format{StorageFormat::Csv};
+    BinaryAccountStore store;
+    std::atomic<size_t> dirtyCount{0};
+    size_t commitThreshold{64};
+    std::chrono::milliseconds commitInterval{200};
+    std::atomic<std::chrono::steady_clock::rep> lastCommit{std::chrono::steady_clock::now().time_since_epoch().count()};
     std::vector<PendingDeposit> pendingDeposits;
     int pendingCounter{0};
+    LoadStats loadStats;
+    unsigned loadThreads{0};
+    static constexpr size_t minLoadChunkBytes = 1 << 20;
+    // Smaller waves of a batch transfer run on the calling thread.
+    static constexpr size_t minParallelTransfers = 1024;
+    // Smaller account bases get their end-of-day run on the calling thread.
+    static constexpr size_t minParallelEndOfDayRows = 1 << 16;
+
+    bool lazy{false};
+    size_t shardMemoryBudget{0};
+    MappedFile snapshotMap;
+    // Rough cost of one resident account besides its holder name: its table
+    // row, its slots in rows/lruPos and its LRU list node.
+    static constexpr size_t residentOverheadBytes = 224;
+    static constexpr size_t NO_ROW = SIZE_MAX;
 
+    static bool toCard(const std::string& accountNumber, uint32_t& card) {
+        return BinaryAccountStore::parseCardNumber(accountNumber, card);
+    }
+
+    size_t shardIndex(uint32_t card) const {
+        // A different multiplier from CardMap's: with the same hash every
+        // card in a shard would share the top bits CardMap picks slots by,
+        // and each shard's table would fill only 1/shards of its slots.
+        return static_cast<size_t>(static_cast<uint64_t>(card * 0x85EBCA6Bu) >> shardShift);
+    }
+
+    Shard& shardFor(uint32_t card) {
+        return shards[shardIndex(card)];
+    }
+
+    std::vector<std::unique_lock<std::shared_mutex>> lockAllShards() {
+        std::vector<std::unique_lock<std::shared_mutex>> guards;
+        guards.reserve(shards.size());
+        for (auto& shard : shards) guards.emplace_back(shard.lock);
+        return guards;
+    }
+
+    // A card is known through its row (resident) or its location (committed
+    // and possibly evicted).
+    void collectCards(const Shard& shard, std::vector<uint32_t>& cards) const {
+        auto collect = [&cards](uint32_t card, const auto&) { cards.push_back(card); };
+        shard.rows.forEach(collect);
+        if (lazy) shard.locations.forEach(collect);
+    }
+
+    static void sortUnique(std::vector<uint32_t>& cards) {
+        std::sort(cards.begin(), cards.end());
+        cards.erase(std::unique(cards.begin(), cards.end()), cards.end());
+    }
+
+    // Takes the shard locks one at a time; callers must not hold any.
+    std::shared_ptr<const std::vector<uint32_t>> sortedCards() {
+        std::lock_guard<std::mutex> guard(orderLock);
+        const uint64_t version = cardSetVersion.load();
+        if (!cardOrder || cardOrderVersion != version) {
+            auto cards = std::make_shared<std::vector<uint32_t>>();
+            for (auto& shard : shards) {
+                std::shared_lock<std::shared_mutex> shardGuard(shard.lock);
+                collectCards(shard, *cards);
+            }
+            sortUnique(*cards);
+            cardOrder = std::move(cards);
+            cardOrderVersion = version;
+        }
+        return cardOrder;
+    }
+
+    static const std::string& holderNameOf(const Shard& shard, size_t row) {
+        static const std::string unknown = "Unknown";
+        return shard.table.holderName(row).empty() ? unknown : shard.table.holderName(row);
+    }
+
+    static std::string formatAccountRow(const Shard& shard, size_t tableRow) {
+        const AccountTable& table = shard.table;
+        std::ostringstream row;
+        row << table.accountNumber(tableRow) << ","
+            << table.pin(tableRow) << ","
+            << std::fixed << std::setprecision(2) << table.balance(tableRow) << ","
+            << AccountTable::typeName(table.type(tableRow)) << ","
+            << holderNameOf(shard, tableRow) << ","
+            << (table.isLocked(tableRow) ? "1" : "0") << ","
+            << table.failedAttempts(tableRow);
+        if (table.overdraftLimitCents(tableRow) != AccountTable::DEFAULT_OVERDRAFT_LIMIT_CENTS) {
+            row << "," << AccountTable::fromCents(table.overdraftLimitCents(tableRow));
+        }
+        row << "\n";
+        return row.str();
+    }
+
+    // The Account view of a table row; one is shared by all holders and
+    // lives only as long as someone holds it.
+    static std::shared_ptr<Account> viewOf(Shard& shard, size_t row) {
+        std::shared_ptr<Account> account = shard.table.cachedView(row);
+        if (!account) {
+            if (shard.table.type(row) == AccountTable::TYPE_SAVINGS) {
+                account = std::make_shared<SavingsAccount>(shard.table, row);
+            } else {
+                account = std::make_shared<CheckingAccount>(shard.table, row);
+            }
+            shard.table.cacheView(row, account);
+        }
+        return account;
+    }
+
+    // Raw text of a committed row that is not resident (lazy mode). Caller
+    // holds storageLock.
+    std::string_view committedRow(const RowLocation& loc, std::string& buffer) {
+        if (loc.source == RowLocation::SNAPSHOT) {
+            if (loc.offset >= snapshotMap.size()) return {};
+            const char* begin = snapshotMap.data() + loc.offset;
+            size_t rest = snapshotMap.size() - static_cast<size_t>(loc.offset);
+            const void* nl = std::memchr(begin, '\n', rest);
+            return std::string_view(begin, nl ? static_cast<size_t>(static_cast<const char*>(nl) - begin) : rest);
+        }
+        if (loc.source == RowLocation::JOURNAL && journal.readRow(loc.offset, buffer)) {
+            return buffer;
+        }
+        return {};
+    }
+
+    // Writes a full snapshot next to the data file and swaps it in, so a crash
+    // mid-write never leaves a truncated snapshot. The journal is only cleared
+    // once the snapshot covering it is in place and synced, along with the
+    // directory entry that points at it. In lazy mode non-resident
+    // rows are copied over from wherever they currently live. Caller holds
+    // commitLock (and, in binary mode, has committed the dirty accounts).
+    void saveToFileLocked() {
+        auto shardGuards = lockAllShards();
+        std::lock_guard<std::mutex> storageGuard(storageLock);
+        if (format == StorageFormat::Binary) {
+            store.sync();
+            return;
+        }
+
+        const std::string tmpFile = dataFile + ".tmp";
+        std::ofstream file(tmpFile, std::ios::trunc | std::ios::binary);
+        if (!file.is_open()) return;
+        std::vector<uint32_t> cards;
+        for (const auto& shard : shards) collectCards(shard, cards);
+        sortUnique(cards);
+        std::vector<uint64_t> newOffsets;
+        if (lazy) newOffsets.reserve(cards.size());
+        std::string buffer;
+        uint64_t offset = 0;
+        for (uint32_t card : cards) {
+            Shard& shard = shardFor(card);
+            std::string row;
+            if (const uint32_t* tableRow = shard.rows.find(card)) {
+                row = formatAccountRow(shard, *tableRow);
+            } else {
+                row = std::string(committedRow(*shard.locations.find(card), buffer));
+                if (!row.empty() && row.back() == '\r') row.pop_back();
+                row += '\n';
+            }
+            file << row;
+            if (lazy) newOffsets.push_back(offset);
+            offset += row.size();
+        }
+        file.close();
+        if (file.fail() || !MappedFile::syncFile(tmpFile)) return;
+
+        snapshotMap.close();
+        bool replaced = std::rename(tmpFile.c_str(), dataFile.c_str()) == 0;
+        if (!replaced) {
+            // Windows will not rename over an existing file
+            std::remove(dataFile.c_str());
+            replaced = std::rename(tmpFile.c_str(), dataFile.c_str()) == 0;
+        }
+        if (replaced) {
+            // The rename has to be on disk before the journal it replaces is
+            // emptied.
+            MappedFile::syncDirectory(".");
+            journal.reset();
+            for (auto& shard : shards) {
+                for (uint32_t card : shard.dirty) shard.table.clearDirty(*shard.rows.find(card));
+                dirtyCount -= shard.dirty.size();
+                shard.dirty.clear();
+            }
+        }
+        if (lazy) {
+            snapshotMap.open(dataFile, false);
+            if (replaced) {
+                for (size_t i = 0; i < cards.size(); ++i) {
+                    shardFor(cards[i]).locations[cards[i]] = {RowLocation::SNAPSHOT, newOffsets[i]};
+                }
+            }
+        }
+    }
+
     void saveToFile() {
-        std::ofstream file(dataFile);
-        if (file.is_open()) {
-            for (auto const& [key, accPtr] : accounts) {
-                std::string name = accountNames.count(key) ? accountNames[key] : "Unknown";
-                bool isLocked = accPtr->getIsLocked();
-                file << accPtr->getAccountNumber() << ","
-                     << accPtr->getPin() << ","
-                     << accPtr->getBalance() << ","
-                     << accPtr->displayAccountType() << ","
-                     << name << ","
-                     << (isLocked ? "1" : "0") << ","
-                     << accPtr->getFailedLoginAttempts() << "\n";
-            }
-            file.close();
+        std::lock_guard<std::mutex> guard(commitLock);
+        if (format == StorageFormat::Binary) commitDirtyLocked();
+        saveToFileLocked();
+    }
+
+    // Commits every dirty account as one group. In binary mode that is a run
+    // of in-place stores into the mapped records followed by a single sync;
+    // otherwise one journal write carrying all rows and a commit marker. The
+    // journal is folded into a new snapshot once it outgrows the account base
+    // so the amortized cost per commit stays constant.
+    //
+    // Rows are captured with all shards locked, so both legs of a transfer
+    // land in the same group; the disk write itself runs with the shards
+    // unlocked. Caller holds commitLock.
+    void commitDirtyLocked() {
+        lastCommit = std::chrono::steady_clock::now().time_since_epoch().count();
+        if (dirtyCount.load() == 0) return;
+
+        std::string group;
+        std::vector<std::pair<uint32_t, uint64_t>> rowOffsets;
+        {
+            auto shardGuards = lockAllShards();
+            std::unique_lock<std::mutex> storageGuard(storageLock, std::defer_lock);
+            if (format == StorageFormat::Binary) storageGuard.lock();
+            for (auto& shard : shards) {
+                for (uint32_t card : shard.dirty) {
+                    const uint32_t* row = shard.rows.find(card);
+                    if (!row) continue;
+                    shard.table.clearDirty(*row);
+                    if (format == StorageFormat::Binary) {
+                        storeAccount(shard, card, *row);
+                    } else {
+                        rowOffsets.emplace_back(card, group.size());
+                        group += formatAccountRow(shard, *row);
+                    }
+                }
+                dirtyCount -= shard.dirty.size();
+                shard.committing.insert(shard.dirty.begin(), shard.dirty.end());
+                shard.dirty.clear();
+            }
+        }
+
+        uint64_t start = 0;
+        {
+            std::lock_guard<std::mutex> storageGuard(storageLock);
+            if (format == StorageFormat::Binary) {
+                store.sync();
+            } else {
+                start = journal.appendGroup(group, rowOffsets.size());
+            }
+        }
+
+        if (lazy) {
+            for (const auto& [card, rel] : rowOffsets) {
+                Shard& shard = shardFor(card);
+                std::lock_guard<std::shared_mutex> guard(shard.lock);
+                shard.locations[card] = {RowLocation::JOURNAL, start + rel};
+            }
+        }
+        for (auto& shard : shards) {
+            std::lock_guard<std::shared_mutex> guard(shard.lock);
+            shard.committing.clear();
+            evictIfOverBudget(shard);
+        }
+
+        if (format == StorageFormat::Csv && journal.size() > std::max(minJournalRecords, accountCount())) {
+            saveToFileLocked();
+        }
+    }
+
+    void commitDirtyAccounts() {
+        std::lock_guard<std::mutex> guard(commitLock);
+        commitDirtyLocked();
+    }
+
+    bool commitIntervalElapsed() const {
+        auto elapsed = std::chrono::steady_clock::now().time_since_epoch().count() - lastCommit.load();
+        return std::chrono::steady_clock::duration(elapsed) >= commitInterval;
+    }
+
+    // Caller holds the shard lock, shared or exclusive; the commit itself is
+    // left to commitIfDue once the lock is released. Only the first change
+    // since the last commit touches the dirty set.
+    void markDirty(Shard& shard, size_t row) {
+        if (!shard.table.markDirty(row)) return;
+        std::lock_guard<std::mutex> guard(shard.dirtyLock);
+        shard.dirty.insert(shard.table.card(row));
+        dirtyCount++;
+    }
+
+    void commitIfDue() {
+        if (dirtyCount.load() >= commitThreshold || (dirtyCount.load() > 0 && commitIntervalElapsed())) {
+            commitDirtyAccounts();
+        }
+    }
+
+    // Writes one shard's dirty accounts as a group of their own, so they can
+    // be evicted again. Caller holds commitLock and the shard exclusively.
+    void commitShardLocked(Shard& shard) {
+        std::string group;
+        std::vector<std::pair<uint32_t, uint64_t>> rowOffsets;
+        std::lock_guard<std::mutex> storageGuard(storageLock);
+        for (uint32_t card : shard.dirty) {
+            const uint32_t* row = shard.rows.find(card);
+            if (!row) continue;
+            shard.table.clearDirty(*row);
+            if (format == StorageFormat::Binary) {
+                storeAccount(shard, card, *row);
+            } else {
+                rowOffsets.emplace_back(card, group.size());
+                group += formatAccountRow(shard, *row);
+            }
+        }
+        dirtyCount -= shard.dirty.size();
+        shard.dirty.clear();
+        if (format == StorageFormat::Binary) {
+            store.sync();
+            return;
+        }
+        const uint64_t start = journal.appendGroup(group, rowOffsets.size());
+        for (const auto& [card, rel] : rowOffsets) shard.locations[card] = {RowLocation::JOURNAL, start + rel};
+    }
+
+    // runEndOfDay's work on one shard, which the caller holds exclusively.
+    // Resident shards are one pass over the table. In lazy mode every
+    // account is paged in, and a changed one is marked dirty before the next
+    // page-in so it cannot be evicted; once the shard's dirty accounts fill
+    // its share of the memory budget they are committed, which lets them go.
+    // peakResident is the most accounts the shard held at once.
+    size_t endOfDayShard(Shard& shard, double rate, int64_t feeCents, AccountTable::EndOfDayTotals& totals,
+                         size_t& peakResident) {
+        AccountTable& table = shard.table;
+        std::vector<uint32_t> changedRows;
+        if (!lazy) {
+            table.applyEndOfDay(0, table.size(), rate, feeCents, changedRows, totals);
+            // markDirty in bulk: sorted cards go into the dirty set in one
+            // hinted pass.
+            std::vector<uint32_t> cards;
+            cards.reserve(changedRows.size());
+            for (uint32_t row : changedRows) {
+                if (table.markDirty(row)) cards.push_back(table.card(row));
+            }
+            std::sort(cards.begin(), cards.end());
+            std::lock_guard<std::mutex> guard(shard.dirtyLock);
+            shard.dirty.insert(cards.begin(), cards.end());
+            dirtyCount += cards.size();
+            peakResident = table.liveCount();
+            return table.liveCount();
+        }
+        std::vector<uint32_t> cards;
+        collectCards(shard, cards);
+        sortUnique(cards);
+        size_t accounts = 0;
+        for (uint32_t card : cards) {
+            size_t row = residentRow(shard, card);
+            if (row == NO_ROW) continue;
+            peakResident = std::max(peakResident, table.liveCount());
+            table.applyEndOfDay(row, row + 1, rate, feeCents, changedRows, totals);
+            if (!changedRows.empty()) markDirty(shard, row);
+            changedRows.clear();
+            if (shard.residentBytes > shardMemoryBudget && !shard.dirty.empty()) commitShardLocked(shard);
+            accounts++;
         }
+        return accounts;
     }
 
+    // Caller holds the shard lock and storageLock.
+    void storeAccount(Shard& shard, uint32_t card, size_t tableRow) {
+        const AccountTable& table = shard.table;
+        if (const RowLocation* loc = shard.locations.find(card)) {
+            store.stage(static_cast<size_t>(loc->offset), table.pin(tableRow), table.balance(tableRow),
+                         table.isLocked(tableRow), table.failedAttempts(tableRow));
+            return;
+        }
+        AccountRow row;
+        row.accountNumber = table.accountNumber(tableRow);
+        row.pin = table.pin(tableRow);
+        row.balance = table.balance(tableRow);
+        row.accountType = AccountTable::typeName(table.type(tableRow));
+        row.holderName = holderNameOf(shard, tableRow);
+        row.locked = table.isLocked(tableRow);
+        row.failedAttempts = table.failedAttempts(tableRow);
+        long long slot = store.append(row);
+        if (slot >= 0) {
+            shard.locations[card] = {RowLocation::STORE, static_cast<uint64_t>(slot)};
+        }
+    }
+
+    // Caller holds pendingLock.
     void savePendingDeposits() {
         std::ofstream file(pendingFile);
         if (file.is_open()) {
             for (auto const& pd : pendingDeposits) {
-                file << pd.id << "," << pd.accountNumber << "," << pd.amount << "," << pd.timestamp << "\n";
+                file << pd.id << "," << pd.accountNumber << "," << pd.amount << ",";
+                if (pd.timestampMs != INT64_MIN) file << pd.timestampMs;
+                file << "\n";
             }
             file.close();
         }
     }
 
+    size_t accountCount() {
+        size_t count = 0;
+        for (auto& shard : shards) {
+            std::shared_lock<std::shared_mutex> guard(shard.lock);
+            count += lazy || format == StorageFormat::Binary ? std::max(shard.locations.size(), shard.rows.size())
+                                                             : shard.rows.size();
+        }
+        return count;
+    }
+
+    static size_t residentFootprint(const Shard& shard, size_t row) {
+        return residentOverheadBytes + shard.table.holderName(row).size();
+    }
+
+    // Registers a freshly resident account with the LRU list (lazy mode only).
+    void trackResident(Shard& shard, uint32_t card) {
+        if (!lazy || shard.lruPos.contains(card)) return;
+        shard.lruOrder.push_front(card);
+        shard.lruPos[card] = shard.lruOrder.begin();
+        shard.residentBytes += residentFootprint(shard, *shard.rows.find(card));
+    }
+
+    static void touchResident(Shard& shard, uint32_t card) {
+        if (auto* pos = shard.lruPos.find(card)) {
+            shard.lruOrder.splice(shard.lruOrder.begin(), shard.lruOrder, *pos);
+        }
+    }
+
+    // The LRU list cannot be reordered under a shared lock, so shared
+    // accesses only stamp the row; eviction moves stamped rows to the front.
+    void touchShared(Shard& shard, size_t row) {
+        if (lazy) shard.table.markUsed(row);
+    }
+
+    // Drops least recently used accounts until the shard fits its share of
+    // the budget. An account used under a shared lock since it was last
+    // seen here counts as just used and moves to the front instead. Dirty or
+    // committing accounts, accounts without a committed row yet and accounts
+    // whose view is still held (an open session) stay.
+    void evictIfOverBudget(Shard& shard) {
+        if (!lazy) return;
+        auto it = shard.lruOrder.end();
+        while (shard.residentBytes > shardMemoryBudget && it != shard.lruOrder.begin()) {
+            --it;
+            const uint32_t card = *it;
+            const uint32_t* row = shard.rows.find(card);
+            if (row && shard.table.takeUsed(*row)) {
+                auto used = it++;
+                shard.lruOrder.splice(shard.lruOrder.begin(), shard.lruOrder, used);
+                continue;
+            }
+            bool pinned = shard.dirty.count(card) || shard.committing.count(card) ||
+                          !shard.locations.contains(card) || (row && shard.table.hasView(*row));
+            if (pinned) continue;
+            if (row) {
+                shard.residentBytes -= residentFootprint(shard, *row);
+                shard.table.release(*row);
+                shard.rows.erase(card);
+            }
+            shard.lruPos.erase(card);
+            it = shard.lruOrder.erase(it);
+        }
+    }
+
+    // Materializes a non-resident account from its committed row and returns
+    // its table row. Room is made before the row is added, so the returned
+    // row stays resident at least until the next page-in. Caller holds the
+    // shard lock.
+    size_t pageIn(Shard& shard, uint32_t card) {
+        const RowLocation* loc = shard.locations.find(card);
+        if (!loc) return NO_ROW;
+        evictIfOverBudget(shard);
+
+        AccountRow row;
+        std::string buffer, accNum, pin, name;
+        std::lock_guard<std::mutex> storageGuard(storageLock);
+        if (loc->source == RowLocation::STORE) {
+            const BinaryAccountStore::Record& rec = store.at(static_cast<size_t>(loc->offset));
+            accNum = BinaryAccountStore::formatCardNumber(rec.cardNumber);
+            pin = BinaryAccountStore::readPin(rec);
+            name = store.readName(rec);
+            row.accountNumber = accNum;
+            row.pin = pin;
+            row.balance = BinaryAccountStore::fromCents(rec.balanceCents);
+            row.accountType = rec.type == BinaryAccountStore::TYPE_SAVINGS ? "Savings Account" : "Checking Account";
+            row.holderName = name;
+            row.locked = rec.locked != 0;
+            row.failedAttempts = rec.failedAttempts;
+        } else if (!parseAccountRow(committedRow(*loc, buffer), row)) {
+            return NO_ROW;
+        }
+
+        insertEntry(shard, makeEntry(row, card));
+        const uint32_t* tableRow = shard.rows.find(card);
+        return tableRow ? *tableRow : NO_ROW;
+    }
+
+    static AccountTable::Entry makeEntry(const AccountRow& row, uint32_t card) {
+        AccountTable::Entry entry;
+        entry.card = card;
+        entry.accountNumber = std::string(row.accountNumber);
+        entry.pin = std::string(row.pin);
+        entry.holderName = std::string(row.holderName);
+        entry.balance = row.balance;
+        entry.type = AccountTable::typeFromName(row.accountType);
+        entry.locked = row.locked;
+        entry.failedAttempts = row.failedAttempts;
+        if (row.hasOverdraftLimit) entry.overdraftLimitCents = AccountTable::toCents(row.overdraftLimit);
+        return entry;
+    }
+
+    // Adds the account, or overwrites its row if the card is already resident
+    // (a journal row replayed over the snapshot).
+    void insertEntry(Shard& shard, AccountTable::Entry&& entry) {
+        const uint32_t card = entry.card;
+        if (uint32_t* row = shard.rows.find(card)) {
+            const bool tracked = shard.lruPos.contains(card);
+            if (tracked) shard.residentBytes -= residentFootprint(shard, *row);
+            shard.table.assign(*row, std::move(entry));
+            if (tracked) shard.residentBytes += residentFootprint(shard, *row);
+            return;
+        }
+        shard.rows[card] = static_cast<uint32_t>(shard.table.append(std::move(entry)));
+        trackResident(shard, card);
+    }
+
+    void insertAccount(const AccountRow& row) {
+        uint32_t card = 0;
+        if (!BinaryAccountStore::parseCardNumber(row.accountNumber, card)) return;
+        insertEntry(shardFor(card), makeEntry(row, card));
+    }
+
+    void applyAccountRow(std::string_view line) {
+        AccountRow row;
+        if (parseAccountRow(line, row)) {
+            insertAccount(row);
+        }
+    }
+
+    // Expected accounts per shard for n accounts, with some slack for an
+    // uneven split.
+    size_t perShard(size_t n) const {
+        return n / shards.size() + n / (shards.size() * 8) + 16;
+    }
+
+    // Maps the snapshot, cuts it into per-thread chunks at line boundaries and
+    // parses the chunks in parallel. Each worker builds table entries into
+    // its own vector; the vectors are then merged in file order, so a card
+    // that appears twice still resolves to its last row.
     void loadFromFile() {
-        std::ifstream file(dataFile);
-        if (file.is_open()) {
-            std::string line;
-            while (std::getline(file, line)) {
-                std::stringstream ss(line);
-                std::string accNum, pin, balanceStr, accType, name, lockedStr, attemptsStr;
-                
-                std::getline(ss, accNum, ',');
-                std::getline(ss, pin, ',');
-                std::getline(ss, balanceStr, ',');
-                std::getline(ss, accType, ',');
-                std::getline(ss, name, ',');
-                std::getline(ss, lockedStr, ',');
-                std::getline(ss, attemptsStr);
-                
-                double balance = std::stod(balanceStr);
-                
-                if (accType == "Savings Account") {
-                    accounts[accNum] = std::make_shared<SavingsAccount>(accNum, pin, balance);
-                } else {
-                    accounts[accNum] = std::make_shared<CheckingAccount>(accNum, pin, balance);
-                }
-                
-                accountNames[accNum] = name.empty() ? "Unknown" : name;
-                
-                bool isLocked = (lockedStr == "1");
-                // Load failed attempts if present (for backward compatibility, default to 0)
-                int attempts = attemptsStr.empty() ? 0 : std::stoi(attemptsStr);
-                accounts[accNum]->setLockedStatus(isLocked, attempts);
+        MappedFile file;
+        if (!file.open(dataFile, false) || file.size() == 0) return;
+        const char* data = file.data();
+        const size_t size = file.size();
+        loadStats.bytes += size;
+
+        size_t workers = loadThreads ? loadThreads : std::max(1u, std::thread::hardware_concurrency());
+        workers = std::max<size_t>(1, std::min(workers, size / minLoadChunkBytes));
+
+        std::vector<size_t> bounds(workers + 1, size);
+        bounds[0] = 0;
+        for (size_t i = 1; i < workers; ++i) {
+            size_t pos = std::max(bounds[i - 1], size / workers * i);
+            const void* nl = std::memchr(data + pos, '\n', size - pos);
+            bounds[i] = nl ? static_cast<size_t>(static_cast<const char*>(nl) - data) + 1 : size;
+        }
+
+        std::vector<std::vector<AccountTable::Entry>> parts(workers);
+        auto parseChunk = [&](size_t part) {
+            const size_t begin = bounds[part];
+            const size_t end = bounds[part + 1];
+            parts[part].reserve((end - begin) / 48);
+            forEachLine(data + begin, end - begin, [&](std::string_view line) {
+                AccountRow row;
+                uint32_t card = 0;
+                if (parseAccountRow(line, row) && BinaryAccountStore::parseCardNumber(row.accountNumber, card)) {
+                    parts[part].push_back(makeEntry(row, card));
+                }
+            });
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t part = 1; part < workers; ++part) {
+            threads.emplace_back(parseChunk, part);
+        }
+        parseChunk(0);
+        for (auto& t : threads) t.join();
+
+        size_t parsed = 0;
+        for (const auto& part : parts) parsed += part.size();
+        for (auto& shard : shards) {
+            shard.rows.reserve(shard.rows.size() + perShard(parsed));
+            shard.table.reserve(shard.table.size() + perShard(parsed));
+        }
+        for (auto& part : parts) {
+            for (auto& entry : part) {
+                insertEntry(shardFor(entry.card), std::move(entry));
             }
-            file.close();
+            loadStats.records += part.size();
+            part.clear();
+            part.shrink_to_fit();
         }
     }
 
+    // Lazy counterpart of loadFromFile: only the card number of each row is
+    // read, and the snapshot stays mapped for paging accounts in later.
+    void indexSnapshot() {
+        if (!snapshotMap.open(dataFile, false) || snapshotMap.size() == 0) return;
+        const char* base = snapshotMap.data();
+        loadStats.bytes += snapshotMap.size();
+        loadStats.records += forEachLine(base, snapshotMap.size(), [&](std::string_view line) {
+            std::string_view rest = line;
+            uint32_t card = 0;
+            if (!BinaryAccountStore::parseCardNumber(nextField(rest), card)) return;
+            shardFor(card).locations[card] = {RowLocation::SNAPSHOT, static_cast<uint64_t>(line.data() - base)};
+        });
+    }
+
+    bool loadFromStore() {
+        if (!store.open(binaryFile, namesFile)) return false;
+        for (auto& shard : shards) {
+            shard.locations.reserve(perShard(store.size()));
+            if (!lazy) {
+                shard.rows.reserve(perShard(store.size()));
+                shard.table.reserve(perShard(store.size()));
+            }
+        }
+        for (size_t slot = 0; slot < store.size(); ++slot) {
+            const BinaryAccountStore::Record& rec = store.at(slot);
+            shardFor(rec.cardNumber).locations[rec.cardNumber] = {RowLocation::STORE, static_cast<uint64_t>(slot)};
+            if (lazy) continue;
+
+            const std::string accNum = BinaryAccountStore::formatCardNumber(rec.cardNumber);
+            const std::string pin = BinaryAccountStore::readPin(rec);
+            const std::string name = store.readName(rec);
+            AccountRow row;
+            row.accountNumber = accNum;
+            row.pin = pin;
+            row.balance = BinaryAccountStore::fromCents(rec.balanceCents);
+            row.accountType = rec.type == BinaryAccountStore::TYPE_SAVINGS ? "Savings Account" : "Checking Account";
+            row.holderName = name;
+            row.locked = rec.locked != 0;
+            row.failedAttempts = rec.failedAttempts;
+            insertAccount(row);
+        }
+        loadStats.bytes += store.size() * sizeof(BinaryAccountStore::Record);
+        loadStats.records += store.size();
+        return true;
+    }
+
     void loadPendingDeposits() {
-        std::ifstream file(pendingFile);
-        if (!file.is_open()) return;
+        MappedFile file;
+        if (!file.open(pendingFile, false) || file.size() == 0) return;
+
+        forEachLine(file.data(), file.size(), [this](std::string_view line) {
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            std::string_view rest = line;
+            std::string_view id = nextField(rest);
+            std::string_view accountNumber = nextField(rest);
+            std::string_view amountText = nextField(rest);
+            std::string_view timestamp = rest;
 
-        std::string line;
-        while (std::getline(file, line)) {
-            std::stringstream ss(line);
             PendingDeposit pd;
-            std::string amountStr;
-            std::getline(ss, pd.id, ',');
-            std::getline(ss, pd.accountNumber, ',');
-            std::getline(ss, amountStr, ',');
-            std::getline(ss, pd.timestamp);
-            if (!pd.id.empty() && !pd.accountNumber.empty() && !amountStr.empty()) {
-                pd.amount = std::stod(amountStr);
-                pendingDeposits.push_back(pd);
-                // track counter based on numeric part if present
-                if (pd.id.size() > 2) {
-                    try {
-                        int num = std::stoi(pd.id.substr(2));
-                        pendingCounter = std::max(pendingCounter, num);
-                    } catch (...) {}
-                }
+            if (id.empty() || accountNumber.empty() || !parseAmount(amountText, pd.amount)) return;
+            pd.id = std::string(id);
+            pd.accountNumber = std::string(accountNumber);
+            // Epoch milliseconds; files from earlier versions hold the text.
+            if (!timestamp.empty() &&
+                std::from_chars(timestamp.data(), timestamp.data() + timestamp.size(), pd.timestampMs).ptr !=
+                    timestamp.data() + timestamp.size() &&
+                !TimeFormat::parse(timestamp, pd.timestampMs)) {
+                pd.timestampMs = INT64_MIN;
+            }
+            pendingDeposits.push_back(std::move(pd));
+            // track counter based on numeric part if present
+            int num = 0;
+            if (id.size() > 2 &&
+                std::from_chars(id.data() + 2, id.data() + id.size(), num).ec == std::errc()) {
+                pendingCounter = std::max(pendingCounter, num);
             }
+        });
+    }
+
+    // Table row of a card, paging it in when lazy; NO_ROW if unknown. Caller
+    // holds the shard lock.
+    size_t residentRow(Shard& shard, uint32_t card) {
+        if (const uint32_t* row = shard.rows.find(card)) {
+            touchResident(shard, card);
+            return *row;
+        }
+        return lazy ? pageIn(shard, card) : NO_ROW;
+    }
+
+    enum class Access { Shared, Exclusive };
+
+    // Runs fn(shard, row) with the account's shard locked. fn returns whether
+    // it changed the account, which then goes into the next group commit.
+    // Returns false if the account is unknown or fn changed nothing. With
+    // Shared access fn may only read the row and change its balance; an
+    // account that first has to be paged in is handled under the exclusive
+    // lock either way.
+    template <typename Fn>
+    bool withAccount(const std::string& accountNumber, Access access, Fn&& fn) {
+        uint32_t card = 0;
+        if (!toCard(accountNumber, card)) return false;
+        Shard& shard = shardFor(card);
+        bool changed = false;
+        bool done = false;
+        if (access == Access::Shared) {
+            std::shared_lock<std::shared_mutex> guard(shard.lock);
+            if (const uint32_t* row = shard.rows.find(card)) {
+                touchShared(shard, *row);
+                changed = fn(shard, static_cast<size_t>(*row));
+                if (changed) markDirty(shard, *row);
+                done = true;
+            } else if (!lazy) {
+                return false;
+            }
+        }
+        if (!done) {
+            std::lock_guard<std::shared_mutex> guard(shard.lock);
+            size_t row = residentRow(shard, card);
+            if (row == NO_ROW) return false;
+            changed = fn(shard, row);
+            if (changed) markDirty(shard, row);
+        }
+        if (changed) commitIfDue();
+        return changed;
+    }
+
+    // Calls fn on a temporary view of the row's concrete account type, so the
+    // type's deposit/withdraw rules apply without touching the view cache.
+    template <typename Fn>
+    static bool withTypedView(AccountTable& table, size_t row, Fn&& fn) {
+        if (table.type(row) == AccountTable::TYPE_SAVINGS) {
+            SavingsAccount view(table, row);
+            return fn(static_cast<Account&>(view));
+        }
+        CheckingAccount view(table, row);
+        return fn(static_cast<Account&>(view));
+    }
+
+    // Both halves of transfer under Lock (shared or exclusive) on the two
+    // shards, taken in ascending index order so concurrent transfers cannot
+    // deadlock. Only the exclusive variant may page accounts in.
+    template <typename Lock>
+    TransferResult transferLocked(uint32_t senderCard, uint32_t recipientCard, int64_t cents) {
+        constexpr bool exclusive = std::is_same_v<Lock, std::unique_lock<std::shared_mutex>>;
+        const size_t senderIndex = shardIndex(senderCard);
+        const size_t recipientIndex = shardIndex(recipientCard);
+        Lock first(shards[std::min(senderIndex, recipientIndex)].lock);
+        Lock second;
+        if (senderIndex != recipientIndex) {
+            second = Lock(shards[std::max(senderIndex, recipientIndex)].lock);
+        }
+
+        Shard& senderShard = shards[senderIndex];
+        Shard& recipientShard = shards[recipientIndex];
+        size_t senderRow = NO_ROW, recipientRow = NO_ROW;
+        std::shared_ptr<Account> pinned;
+        if constexpr (exclusive) {
+            // The held view keeps the sender resident while the recipient
+            // is paged in.
+            senderRow = residentRow(senderShard, senderCard);
+            if (senderRow != NO_ROW) pinned = viewOf(senderShard, senderRow);
+            recipientRow = residentRow(recipientShard, recipientCard);
+        } else {
+            if (const uint32_t* row = senderShard.rows.find(senderCard)) senderRow = *row;
+            if (const uint32_t* row = recipientShard.rows.find(recipientCard)) recipientRow = *row;
+        }
+        if (senderRow == NO_ROW) return TransferResult::UnknownSender;
+        if (recipientRow == NO_ROW) return TransferResult::UnknownRecipient;
+        if constexpr (!exclusive) {
+            touchShared(senderShard, senderRow);
+            touchShared(recipientShard, recipientRow);
+        }
+
+        if (senderShard.table.isLocked(senderRow)) return TransferResult::SenderLocked;
+        if (recipientShard.table.isLocked(recipientRow)) return TransferResult::RecipientLocked;
+        if (!senderShard.table.adjustBalance(senderRow, -cents, 0)) return TransferResult::InsufficientFunds;
+        recipientShard.table.adjustBalance(recipientRow, cents, 0);
+        markDirty(senderShard, senderRow);
+        markDirty(recipientShard, recipientRow);
+        return TransferResult::Ok;
+    }
+
+    // What can be told about a transfer without looking at either account.
+    static TransferResult checkTransfer(const std::string& fromAccount, const std::string& toAccount, double amount,
+                                        uint32_t& senderCard, uint32_t& recipientCard) {
+        if (!(amount > 0)) return TransferResult::InvalidAmount;
+        if (!toCard(fromAccount, senderCard)) return TransferResult::UnknownSender;
+        if (!toCard(toAccount, recipientCard)) return TransferResult::UnknownRecipient;
+        if (senderCard == recipientCard) return TransferResult::SameAccount;
+        return TransferResult::Ok;
+    }
+
+    // transferLocked with the shards shared, retried exclusively when a lazy
+    // account has to be paged in. Leaves the commit to the caller.
+    TransferResult transferCards(uint32_t senderCard, uint32_t recipientCard, int64_t cents) {
+        TransferResult result = transferLocked<std::shared_lock<std::shared_mutex>>(senderCard, recipientCard, cents);
+        if ((result == TransferResult::UnknownSender || result == TransferResult::UnknownRecipient) && lazy) {
+            result = transferLocked<std::unique_lock<std::shared_mutex>>(senderCard, recipientCard, cents);
+        }
+        return result;
+    }
+
+    // Calls a visitor that may return bool (false = stop) or void.
+    template <typename Fn, typename... Args>
+    static bool visit(Fn& fn, Args&&... args) {
+        if constexpr (std::is_same_v<decltype(fn(std::forward<Args>(args)...)), bool>) {
+            return fn(std::forward<Args>(args)...);
+        } else {
+            fn(std::forward<Args>(args)...);
+            return true;
         }
-        file.close();
     }
 
     std::string nextPendingId() {
@@ -125,113 +1009,579 @@ private:
     }
 
 public:
-    Bank() {
-        loadFromFile();
+    Bank() : Bank(Options()) {}
+
+    // Recovery: load the last snapshot, then replay the journal on top of it.
+    // Requesting Binary without a .bin file converts the CSV data first.
+    // Nothing else can see the Bank yet, so loading takes no locks.
+    explicit Bank(const Options& options) {
+        size_t shardCount = 1;
+        while (shardCount < options.shardCount) {
+            shardCount <<= 1;
+            --shardShift;
+        }
+        shards = std::vector<Shard>(shardCount);
+        for (auto& shard : shards) shard.table.setHistoryCapacity(options.historyLength);
+        format = options.format;
+        loadThreads = options.loadThreads;
+        lazy = options.lazyLoad;
+        shardMemoryBudget = options.memoryBudgetBytes / shardCount;
+        commitThreshold = std::max<size_t>(options.commitThreshold, 1);
+        commitInterval = std::chrono::milliseconds(options.commitIntervalMs);
+        if (format == StorageFormat::Auto) {
+            format = std::ifstream(binaryFile).good() ? StorageFormat::Binary : StorageFormat::Csv;
+        }
+        if (format == StorageFormat::Binary && !std::ifstream(binaryFile).good()) {
+            size_t imported = 0;
+            convertToBinary(imported);
+        }
+        auto loadStart = std::chrono::steady_clock::now();
+        if (format == StorageFormat::Binary && !loadFromStore()) {
+            format = StorageFormat::Csv;
+        }
+        if (format == StorageFormat::Csv && lazy) {
+            indexSnapshot();
+            loadStats.records += journal.replay([this](const std::string& line, uint64_t offset) {
+                std::string_view rest = line;
+                uint32_t card = 0;
+                if (BinaryAccountStore::parseCardNumber(nextField(rest), card)) {
+                    shardFor(card).locations[card] = {RowLocation::JOURNAL, offset};
+                }
+            });
+        } else if (format == StorageFormat::Csv) {
+            loadFromFile();
+            loadStats.records += journal.replay([this](const std::string& line, uint64_t) { applyAccountRow(line); });
+        }
+        loadStats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
         loadPendingDeposits();
     }
+
+    const LoadStats& getLoadStats() const {
+        return loadStats;
+    }
+
+    ~Bank() {
+        flush();
+    }
+
+    // One-way migration of bank_accounts.dat (+ journal) to bank_accounts.bin.
+    // The CSV files are left untouched as a backup.
+    static bool convertToBinary(size_t& imported) {
+        return BinaryAccountStore::importCsv(dataFile, journalFile, binaryFile, namesFile, imported);
+    }
 
     bool createAccount(const std::string& cardNumber, const std::string& pin, const std::string& accountType, const std::string& holderName, double initialBalance = 0.0) {
-        if (accounts.find(cardNumber) != accounts.end()) {
-            return false; // Account already exists
+        uint32_t card = 0;
+        if (!toCard(cardNumber, card)) {
+            return false;
         }
-        
-        if (accountType == "Savings") {
-            accounts[cardNumber] = std::make_shared<SavingsAccount>(cardNumber, pin, initialBalance);
-        } else {
-            accounts[cardNumber] = std::make_shared<CheckingAccount>(cardNumber, pin, initialBalance);
+
+        AccountTable::Entry entry;
+        entry.card = card;
+        entry.accountNumber = cardNumber;
+        entry.pin = pin;
+        entry.holderName = holderName;
+        entry.balance = initialBalance;
+        entry.type = accountType == "Savings" ? AccountTable::TYPE_SAVINGS : AccountTable::TYPE_CHECKING;
+
+        {
+            Shard& shard = shardFor(card);
+            std::lock_guard<std::shared_mutex> guard(shard.lock);
+            if (shard.rows.contains(card) || shard.locations.contains(card)) {
+                return false; // Account already exists
+            }
+            insertEntry(shard, std::move(entry));
+            markDirty(shard, *shard.rows.find(card));
         }
-        
-        accountNames[cardNumber] = holderName;
-        saveToFile();
+        cardSetVersion++;
+        commitIfDue();
         return true;
     }
 
-    void addAccount(std::shared_ptr<Account> account) {
-        accounts[account->getAccountNumber()] = account;
-        saveToFile();
-    }
-
-    std::shared_ptr<Account> getAccount(const std::string& accountNumber) const {
-        auto it = accounts.find(accountNumber);
-        if (it != accounts.end()) {
-            return it->second;
-        }
-        return nullptr;
+    // In lazy mode this pages the account in on first access; see the class
+    // comment for what the view may do.
+    std::shared_ptr<Account> getAccount(const std::string& accountNumber) {
+        std::shared_ptr<Account> account;
+        withAccount(accountNumber, Access::Exclusive, [&account](Shard& shard, size_t row) {
+            account = viewOf(shard, row);
+            return false;
+        });
+        return account;
     }
 
-    std::string getAccountName(const std::string& accountNumber) const {
-        auto it = accountNames.find(accountNumber);
-        if (it != accountNames.end()) {
-            return it->second;
-        }
-        return "Unknown";
+    std::string getAccountName(const std::string& accountNumber) {
+        std::string name = "Unknown";
+        withAccount(accountNumber, Access::Shared, [&name](Shard& shard, size_t row) {
+            name = holderNameOf(shard, row);
+            return false;
+        });
+        return name;
+    }
+
+    // Atomic balance changes with the same rules as Account::deposit /
+    // withdraw (checking accounts may overdraw).
+    bool deposit(const std::string& accountNumber, double amount) {
+        return withAccount(accountNumber, Access::Shared, [amount](Shard& shard, size_t row) {
+            return withTypedView(shard.table, row, [amount](Account& account) { return account.deposit(amount); });
+        });
+    }
+
+    bool withdraw(const std::string& accountNumber, double amount) {
+        return withAccount(accountNumber, Access::Shared, [amount](Shard& shard, size_t row) {
+            return withTypedView(shard.table, row, [amount](Account& account) { return account.withdraw(amount); });
+        });
+    }
+
+    // The account's last transactions, oldest first, at most
+    // Options::historyLength of them. The full history is in the transaction
+    // log (TransactionLog::Cursor).
+    std::vector<Transaction> getRecentTransactions(const std::string& accountNumber) {
+        std::vector<Transaction> recent;
+        withAccount(accountNumber, Access::Shared, [&recent](Shard& shard, size_t row) {
+            recent = shard.table.recentHistory(row);
+            return false;
+        });
+        return recent;
+    }
+
+    // Adds balance * rate to a savings account, rounded to the cent, as one
+    // compare-and-swap; false for an unknown or checking account.
+    bool applyInterest(const std::string& accountNumber, double rate) {
+        return withAccount(accountNumber, Access::Shared, [rate](Shard& shard, size_t row) {
+            if (shard.table.type(row) != AccountTable::TYPE_SAVINGS) return false;
+            shard.table.applyRate(row, rate);
+            return true;
+        });
+    }
+
+    // Appends a transaction to the account's in-memory history ring. The
+    // ring is not atomic, so this takes the shard exclusively; the
+    // transaction itself is persisted by TransactionLog, not by a commit.
+    bool recordHistory(const std::string& accountNumber, const Transaction& trans) {
+        bool found = false;
+        withAccount(accountNumber, Access::Exclusive, [&](Shard& shard, size_t row) {
+            shard.table.addHistory(row, trans);
+            found = true;
+            return false;
+        });
+        return found;
+    }
+
+    // Moves amount from one account to another as one atomic step with
+    // respect to commits. The sender needs the full amount (no overdraft) and
+    // neither account may be locked. Resident accounts only need both
+    // shards shared; the exclusive retry pages lazy accounts in.
+    TransferResult transfer(const std::string& fromAccount, const std::string& toAccount, double amount) {
+        uint32_t senderCard = 0, recipientCard = 0;
+        const TransferResult checked = checkTransfer(fromAccount, toAccount, amount, senderCard, recipientCard);
+        if (checked != TransferResult::Ok) return checked;
+        TransferResult result = transferCards(senderCard, recipientCard, AccountTable::toCents(amount));
+        if (result == TransferResult::Ok) commitIfDue();
+        return result;
+    }
+
+    // Runs many transfers and commits them as one group; results[i] is the
+    // outcome of requests[i]. The outcome is the same as running them one by
+    // one in order: requests are split into waves, each transfer going into
+    // the first wave after the last one that touched either of its accounts,
+    // so a wave's transfers share no account and run in parallel (on
+    // threads workers, 0 = one per core), while transfers on the same
+    // account keep their order. commitLock is held throughout, so no other
+    // session's commit can persist part of a batch before it ends.
+    std::vector<TransferResult> transferBatch(const std::vector<TransferRequest>& requests, unsigned threads = 0) {
+        return transferBatch(requests, threads, [](const std::vector<TransferResult>&) {});
+    }
+
+    // As above, calling beforeCommit(results) once every transfer has been
+    // applied but before any of them is committed. Whatever beforeCommit
+    // writes (the batch's transaction log entries, say) is out before the
+    // balances are.
+    template <typename Fn>
+    std::vector<TransferResult> transferBatch(const std::vector<TransferRequest>& requests, unsigned threads,
+                                              Fn&& beforeCommit) {
+        const size_t n = requests.size();
+        std::vector<TransferResult> results(n, TransferResult::Ok);
+        std::vector<uint32_t> senders(n), recipients(n), waves(n, UINT32_MAX);
+        std::vector<int64_t> cents(n);
+        CardMap<uint32_t> nextFreeWave;
+        uint32_t waveCount = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const TransferRequest& request = requests[i];
+            results[i] = checkTransfer(request.fromAccount, request.toAccount, request.amount, senders[i], recipients[i]);
+            if (results[i] == TransferResult::Ok) {
+                const uint32_t* senderFree = nextFreeWave.find(senders[i]);
+                const uint32_t* recipientFree = nextFreeWave.find(recipients[i]);
+                waves[i] = std::max(senderFree ? *senderFree : 0u, recipientFree ? *recipientFree : 0u);
+                nextFreeWave[senders[i]] = waves[i] + 1;
+                nextFreeWave[recipients[i]] = waves[i] + 1;
+                waveCount = std::max(waveCount, waves[i] + 1);
+                cents[i] = AccountTable::toCents(request.amount);
+            }
+        }
+
+        // Requests grouped by wave, each wave in request order.
+        std::vector<size_t> waveStart(waveCount + 1, 0);
+        for (uint32_t wave : waves) {
+            if (wave != UINT32_MAX) waveStart[wave + 1]++;
+        }
+        for (uint32_t wave = 0; wave < waveCount; ++wave) waveStart[wave + 1] += waveStart[wave];
+        std::vector<size_t> order(waveStart[waveCount]);
+        {
+            std::vector<size_t> fill(waveStart.begin(), waveStart.end() - 1);
+            for (size_t i = 0; i < n; ++i) {
+                if (waves[i] != UINT32_MAX) order[fill[waves[i]]++] = i;
+            }
+        }
+
+        std::lock_guard<std::mutex> commitGuard(commitLock);
+        const size_t workers = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        auto run = [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                const size_t i = order[k];
+                results[i] = transferCards(senders[i], recipients[i], cents[i]);
+            }
+        };
+        for (uint32_t wave = 0; wave < waveCount; ++wave) {
+            const size_t begin = waveStart[wave];
+            const size_t end = waveStart[wave + 1];
+            const size_t parts = std::max<size_t>(1, std::min(workers, (end - begin) / minParallelTransfers));
+            std::vector<std::thread> workerThreads;
+            for (size_t part = 1; part < parts; ++part) {
+                workerThreads.emplace_back(run, begin + (end - begin) * part / parts, begin + (end - begin) * (part + 1) / parts);
+            }
+            run(begin, begin + (end - begin) / parts);
+            for (auto& t : workerThreads) t.join();
+        }
+        beforeCommit(static_cast<const std::vector<TransferResult>&>(results));
+        commitDirtyLocked();
+        return results;
+    }
+
+    // Reads a batch transfer file of from,to,amount lines. A first line whose
+    // amount is not a number is a header and skipped; any other line that
+    // does not parse becomes a request that fails with InvalidAmount, so
+    // results stay aligned with the file's lines.
+    static bool readTransferBatch(const std::string& path, std::vector<TransferRequest>& requests) {
+        requests.clear();
+        MappedFile file;
+        if (!file.open(path, false)) return false;
+        forEachLine(file.data(), file.size(), [&requests](std::string_view line) {
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (line.empty()) return;
+            std::string_view rest = line;
+            TransferRequest request;
+            request.fromAccount = std::string(nextField(rest));
+            request.toAccount = std::string(nextField(rest));
+            const bool parsed = parseAmount(nextField(rest), request.amount);
+            if (!parsed && requests.empty()) return;
+            if (!parsed) request.amount = 0.0;
+            requests.push_back(std::move(request));
+        });
+        return true;
+    }
+
+    // Writes a from,to,amount,result line per request.
+    static bool writeTransferResults(const std::string& path, const std::vector<TransferRequest>& requests,
+                                     const std::vector<TransferResult>& results) {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file.is_open()) return false;
+        file << "from,to,amount,result\n" << std::fixed << std::setprecision(2);
+        for (size_t i = 0; i < requests.size() && i < results.size(); ++i) {
+            file << requests[i].fromAccount << "," << requests[i].toAccount << "," << requests[i].amount << ","
+                 << transferResultName(results[i]) << "\n";
+        }
+        return file.good();
+    }
+
+    static const char* transferResultName(TransferResult result) {
+        switch (result) {
+        case TransferResult::Ok: return "OK";
+        case TransferResult::InvalidAmount: return "INVALID_AMOUNT";
+        case TransferResult::SameAccount: return "SAME_ACCOUNT";
+        case TransferResult::UnknownSender: return "UNKNOWN_SENDER";
+        case TransferResult::UnknownRecipient: return "UNKNOWN_RECIPIENT";
+        case TransferResult::SenderLocked: return "SENDER_LOCKED";
+        case TransferResult::RecipientLocked: return "RECIPIENT_LOCKED";
+        case TransferResult::InsufficientFunds: return "INSUFFICIENT_FUNDS";
+        }
+        return "";
     }
 
-    const std::map<std::string, std::shared_ptr<Account>>& getAllAccounts() const {
-        return accounts;
+    // End-of-day processing of every account in one pass: savings accounts
+    // earn interestRate and checking accounts below zero pay overdraftFee,
+    // never past the account's own overdraft limit. All shards are
+    // held exclusively while balances change, so no session sees half a run,
+    // and they are split across threads workers (0 = one per core). commitLock
+    // is held throughout, so the run reaches disk as a single commit, except
+    // in lazy mode: there each shard commits whenever its changed accounts
+    // fill its share of memoryBudgetBytes, so memory stays within the budget
+    // but a crash part way through can leave some of the run on disk.
+    EndOfDayStats runEndOfDay(double interestRate, double overdraftFee, unsigned threads = 0) {
+        const auto start = std::chrono::steady_clock::now();
+        const int64_t feeCents = std::max<int64_t>(AccountTable::toCents(overdraftFee), 0);
+        EndOfDayStats stats;
+        std::lock_guard<std::mutex> commitGuard(commitLock);
+        {
+            auto shardGuards = lockAllShards();
+            size_t rows = 0;
+            for (auto& shard : shards) rows += lazy ? shard.locations.size() : shard.table.size();
+            const size_t workers = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+            const size_t parts = std::max<size_t>(1, std::min({workers, shards.size(), rows / minParallelEndOfDayRows}));
+
+            std::vector<AccountTable::EndOfDayTotals> totals(shards.size());
+            std::vector<size_t> accounts(shards.size(), 0);
+            std::vector<size_t> peakResident(shards.size(), 0);
+            std::atomic<size_t> nextShard{0};
+            auto run = [&]() {
+                for (size_t i = nextShard++; i < shards.size(); i = nextShard++) {
+                    accounts[i] = endOfDayShard(shards[i], interestRate, feeCents, totals[i], peakResident[i]);
+                }
+            };
+            std::vector<std::thread> workerThreads;
+            for (size_t part = 1; part < parts; ++part) workerThreads.emplace_back(run);
+            run();
+            for (auto& t : workerThreads) t.join();
+
+            int64_t interestCents = 0, feeTotalCents = 0;
+            for (size_t i = 0; i < shards.size(); ++i) {
+                stats.accounts += accounts[i];
+                stats.peakResidentAccounts += peakResident[i];
+                stats.interestCredited += totals[i].credited;
+                stats.feesCharged += totals[i].charged;
+                interestCents += totals[i].interestCents;
+                feeTotalCents += totals[i].feeCents;
+            }
+            stats.interestPaid = AccountTable::fromCents(interestCents);
+            stats.feesCollected = AccountTable::fromCents(feeTotalCents);
+        }
+        commitDirtyLocked();
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+    // Visits every account in card-number order; fn may return false to stop
+    // early. fn runs with no lock held. In lazy mode accounts are paged in
+    // one at a time, so a full scan stays within the memory budget. Bulk
+    // operations that do not need Account objects or ordering should use
+    // forEachRow instead.
+    template <typename Fn>
+    void forEachAccount(Fn&& fn) {
+        std::shared_ptr<const std::vector<uint32_t>> cards = sortedCards();
+        for (uint32_t card : *cards) {
+            std::shared_ptr<Account> account;
+            {
+                Shard& shard = shardFor(card);
+                std::lock_guard<std::shared_mutex> guard(shard.lock);
+                size_t row = residentRow(shard, card);
+                if (row != NO_ROW) account = viewOf(shard, row);
+            }
+            if (account && !visit(fn, account)) return;
+        }
+    }
+
+    // Visits every account as fn(table, row) without creating Account views;
+    // fn may return false to stop early. With everything resident this is a
+    // straight pass over each shard's columns in row order; in lazy mode rows
+    // are paged in card by card and a row is only valid during its call. fn
+    // runs with the row's shard locked and must not call back into the Bank.
+    template <typename Fn>
+    void forEachRow(Fn&& fn) {
+        if (!lazy) {
+            for (auto& shard : shards) {
+                std::shared_lock<std::shared_mutex> guard(shard.lock);
+                const AccountTable& table = shard.table;
+                for (size_t row = 0; row < table.size(); ++row) {
+                    if (table.isLive(row) && !visit(fn, table, row)) return;
+                }
+            }
+            return;
+        }
+        std::shared_ptr<const std::vector<uint32_t>> cards = sortedCards();
+        for (uint32_t card : *cards) {
+            Shard& shard = shardFor(card);
+            std::lock_guard<std::shared_mutex> guard(shard.lock);
+            size_t row = residentRow(shard, card);
+            if (row != NO_ROW && !visit(fn, static_cast<const AccountTable&>(shard.table), row)) return;
+        }
+    }
+
+    // Like forEachRow, but fn(table, row) may change the row and returns
+    // whether it did; changed accounts go into the next group commit.
+    template <typename Fn>
+    void updateEachRow(Fn&& fn) {
+        if (!lazy) {
+            for (auto& shard : shards) {
+                std::lock_guard<std::shared_mutex> guard(shard.lock);
+                AccountTable& table = shard.table;
+                for (size_t row = 0; row < table.size(); ++row) {
+                    if (table.isLive(row) && fn(table, row)) markDirty(shard, row);
+                }
+            }
+        } else {
+            std::shared_ptr<const std::vector<uint32_t>> cards = sortedCards();
+            for (uint32_t card : *cards) {
+                Shard& shard = shardFor(card);
+                std::lock_guard<std::shared_mutex> guard(shard.lock);
+                size_t row = residentRow(shard, card);
+                if (row != NO_ROW && fn(shard.table, row)) markDirty(shard, row);
+            }
+        }
+        commitIfDue();
+    }
+
+    // Per resident account that has recorded transactions since it was
+    // loaded, what its history ring holds and costs, by account number.
+    std::vector<HistoryUsage> getHistoryUsage() {
+        std::vector<HistoryUsage> usage;
+        forEachRow([&usage](const AccountTable& table, size_t row) {
+            if (table.historyAdded(row) == 0) return;
+            usage.push_back(HistoryUsage{table.accountNumber(row), table.historySize(row),
+                                         table.getHistoryCapacity(), table.historyAdded(row),
+                                         table.historyBytes(row)});
+        });
+        std::sort(usage.begin(), usage.end(), [](const HistoryUsage& a, const HistoryUsage& b) {
+            return a.accountNumber < b.accountNumber;
+        });
+        return usage;
+    }
+
+    size_t getAccountCount() {
+        return accountCount();
+    }
+
+    size_t getResidentAccountCount() {
+        size_t count = 0;
+        for (auto& shard : shards) {
+            std::shared_lock<std::shared_mutex> guard(shard.lock);
+            count += shard.rows.size();
+        }
+        return count;
     }
 
+    // Whether the account is in memory right now (always, unless lazy).
+    bool isResident(const std::string& accountNumber) {
+        uint32_t card = 0;
+        if (!toCard(accountNumber, card)) return false;
+        Shard& shard = shardFor(card);
+        std::shared_lock<std::shared_mutex> guard(shard.lock);
+        return shard.rows.contains(card);
+    }
+
     bool verifyPIN(const std::string& accountNumber, const std::string& pin) {
-        auto account = getAccount(accountNumber);
-        if (account) {
-            return account->getPin() == pin;
-        }
-        return false;
+        bool matches = false;
+        withAccount(accountNumber, Access::Shared, [&](Shard& shard, size_t row) {
+            matches = shard.table.pin(row) == pin;
+            return false;
+        });
+        return matches;
     }
 
-    bool accountExists(const std::string& accountNumber) const {
-        return accounts.find(accountNumber) != accounts.end();
+    bool accountExists(const std::string& accountNumber) {
+        uint32_t card = 0;
+        if (!toCard(accountNumber, card)) return false;
+        Shard& shard = shardFor(card);
+        std::shared_lock<std::shared_mutex> guard(shard.lock);
+        return shard.rows.contains(card) || shard.locations.contains(card);
     }
 
-    bool isAccountLocked(const std::string& accountNumber) const {
-        auto account = getAccount(accountNumber);
-        if (account) {
-            return account->getIsLocked();
-        }
-        return false;
+    bool isAccountLocked(const std::string& accountNumber) {
+        bool locked = false;
+        withAccount(accountNumber, Access::Shared, [&locked](Shard& shard, size_t row) {
+            locked = shard.table.isLocked(row);
+            return false;
+        });
+        return locked;
     }
 
 
 bool setAccountLock(const std::string& accountNumber, bool locked) {
-    std::shared_ptr<Account> account = getAccount(accountNumber);
-    
-    if (!account) { 
-        return false;
-    }
-    
-    // update card state for locking and stuff
-    if (locked) {
-        account->lockCard();
-    } else {
-        // This is the UNLOCK action, which also resets failed attempts
-        account->unlockCard(); 
-    }
-    
-    updateAccountData(); 
-    
-    return true;
+    return withAccount(accountNumber, Access::Exclusive, [locked](Shard& shard, size_t row) {
+        // update card state for locking and stuff
+        if (locked) {
+            shard.table.setLocked(row, true);
+        } else {
+            // This is the UNLOCK action, which also resets failed attempts
+            shard.table.setLocked(row, false);
+            shard.table.setFailedAttempts(row, 0);
+        }
+        return true;
+    });
 }
 
+    // Sets a new PIN under the account's shard lock.
+    bool changePin(const std::string& accountNumber, const std::string& newPin) {
+        return withAccount(accountNumber, Access::Exclusive, [&newPin](Shard& shard, size_t row) {
+            shard.table.setPin(row, newPin);
+            return true;
+        });
+    }
+
+    // Counts a wrong PIN and locks the card once maxPinAttempts is reached,
+    // in one step so concurrent sessions cannot both slip under the limit.
+    // Returns the attempts so far, or 0 if the account is unknown.
+    int recordFailedPin(const std::string& accountNumber) {
+        int attempts = 0;
+        withAccount(accountNumber, Access::Exclusive, [&attempts](Shard& shard, size_t row) {
+            attempts = shard.table.failedAttempts(row) + 1;
+            shard.table.setFailedAttempts(row, attempts);
+            if (attempts >= maxPinAttempts) shard.table.setLocked(row, true);
+            return true;
+        });
+        return attempts;
+    }
+
+    // After a successful login; only journaled if there was a count to clear.
+    void resetFailedAttempts(const std::string& accountNumber) {
+        withAccount(accountNumber, Access::Exclusive, [](Shard& shard, size_t row) {
+            if (shard.table.failedAttempts(row) == 0) return false;
+            shard.table.setFailedAttempts(row, 0);
+            return true;
+        });
+    }
+
+    // Marks a mutated account for the next group commit.
+    void updateAccountData(const std::string& accountNumber) {
+        withAccount(accountNumber, Access::Shared, [](Shard&, size_t) { return true; });
+    }
+
+    // Checkpoint: rewrites the whole snapshot and clears the journal.
     void updateAccountData() {
         saveToFile();
     }
 
-    const std::vector<PendingDeposit>& getPendingDeposits() const {
+    // Commits pending changes if the commit interval has elapsed; call
+    // periodically so a lone update does not wait for the next mutation.
+    void flushIfDue() {
+        if (dirtyCount.load() > 0 && commitIntervalElapsed()) {
+            commitDirtyAccounts();
+        }
+    }
+
+    // Commits all pending changes now (shutdown, admin actions).
+    void flush() {
+        commitDirtyAccounts();
+    }
+
+    // A copy, since other sessions may add or approve deposits meanwhile.
+    std::vector<PendingDeposit> getPendingDeposits() {
+        std::lock_guard<std::mutex> guard(pendingLock);
         return pendingDeposits;
     }
 
-    std::string addPendingDeposit(const std::string& accountNumber, double amount, const std::string& timestamp) {
+    std::string addPendingDeposit(const std::string& accountNumber, double amount, int64_t timestampMs) {
+        std::lock_guard<std::mutex> guard(pendingLock);
         PendingDeposit pd;
         pd.id = nextPendingId();
         pd.accountNumber = accountNumber;
         pd.amount = amount;
-        pd.timestamp = timestamp;
+        pd.timestampMs = timestampMs;
         pendingDeposits.push_back(pd);
         savePendingDeposits();
         return pd.id;
     }
 
     bool takePendingDeposit(const std::string& id, PendingDeposit& out) {
+        std::lock_guard<std::mutex> guard(pendingLock);
         for (auto it = pendingDeposits.begin(); it != pendingDeposits.end(); ++it) {
             if (it->id == id) {
                 out = *it;
@@ -0,0 +1,321 @@
+#ifndef BINARYACCOUNTSTORE_H
+#define BINARYACCOUNTSTORE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include "MappedFile.h"
+#include "AccountRow.h"
+#include "AccountJournal.h"
+#include "CardMap.h"
+
+// Fixed-width binary account store (bank_accounts.bin), memory-mapped so a
+// balance update is a single in-place 8-byte store and startup is a walk over
+// packed records instead of text parsing. Holder names live in a sidecar
+// heap file (bank_accounts.names) and are referenced by offset/length.
+//
+// Changes to existing records go through stage() and land in sync(). A sync
+// that rewrites more than one record (the two sides of a transfer, say)
+// first writes their new images to an intent file (bank_accounts.bin.intent)
+// and syncs it, so a crash part way through copying them into the store is
+// finished by the next open() instead of leaving half a group. New accounts
+// are appended straight to the store, one record each.
+class BinaryAccountStore {
+public:
+    enum : uint8_t { TYPE_SAVINGS = 0, TYPE_CHECKING = 1 };
+
+    struct Record {
+        int64_t balanceCents;
+        uint64_t nameOffset;
+        uint32_t cardNumber;
+        char pin[4];
+        uint16_t nameLength;
+        uint8_t type;
+        uint8_t locked;
+        uint8_t failedAttempts;
+        uint8_t reserved[3];
+    };
+    static_assert(sizeof(Record) == 32, "Record layout is part of the file format");
+
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t count;
+        uint64_t capacity;
+    };
+    static_assert(sizeof(Header) == 32, "Header layout is part of the file format");
+
+    static constexpr char MAGIC[8] = {'A', 'T', 'M', 'A', 'C', 'C', 'T', '1'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint64_t INITIAL_CAPACITY = 1024;
+
+    // The intent file: a header, then count staged records. count is zeroed
+    // (and synced) once the records are in the store.
+    struct IntentHeader {
+        char magic[8];
+        uint64_t count;
+        uint64_t checksum; // FNV-1a of the entries
+    };
+    struct IntentEntry {
+        uint64_t slot;
+        Record record;
+    };
+    static_assert(sizeof(IntentHeader) == 24 && sizeof(IntentEntry) == 40, "Intent layout is part of the file format");
+    static constexpr char INTENT_MAGIC[8] = {'A', 'T', 'M', 'I', 'N', 'T', 'N', '1'};
+
+    MappedFile records;
+    std::string intentPath;
+    std::vector<IntentEntry> staged;
+    MappedFile namesMap;
+    std::string namesPath;
+    std::ofstream namesOut;
+    uint64_t namesSize{0};
+
+    Header& header() { return *reinterpret_cast<Header*>(records.data()); }
+    const Header& header() const { return *reinterpret_cast<const Header*>(records.data()); }
+    Record* recordBase() { return reinterpret_cast<Record*>(records.data() + sizeof(Header)); }
+    const Record* recordBase() const { return reinterpret_cast<const Record*>(records.data() + sizeof(Header)); }
+
+    static uint64_t checksum(const IntentEntry* entries, size_t count) {
+        uint64_t hash = 14695981039346656037ull;
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(entries);
+        for (size_t i = 0; i < count * sizeof(IntentEntry); ++i) hash = (hash ^ bytes[i]) * 1099511628211ull;
+        return hash;
+    }
+
+    static void fillRecord(Record& rec, std::string_view pin, double balance, bool locked, int failedAttempts) {
+        rec.balanceCents = toCents(balance);
+        std::memset(rec.pin, 0, sizeof(rec.pin));
+        std::memcpy(rec.pin, pin.data(), std::min(pin.size(), sizeof(rec.pin)));
+        rec.locked = locked ? 1 : 0;
+        rec.failedAttempts = static_cast<uint8_t>(std::min(failedAttempts, 255));
+    }
+
+    // Copies a complete intent left by a crash into the store. A torn one
+    // (bad checksum) was never acted on, so it is ignored.
+    void recoverIntent() {
+        MappedFile intent;
+        if (!intent.open(intentPath, true) || intent.size() < sizeof(IntentHeader)) return;
+        IntentHeader& h = *reinterpret_cast<IntentHeader*>(intent.data());
+        const IntentEntry* entries = reinterpret_cast<const IntentEntry*>(intent.data() + sizeof(IntentHeader));
+        if (std::memcmp(h.magic, INTENT_MAGIC, sizeof(INTENT_MAGIC)) != 0 || h.count == 0 ||
+            h.count > (intent.size() - sizeof(IntentHeader)) / sizeof(IntentEntry) ||
+            h.checksum != checksum(entries, static_cast<size_t>(h.count))) {
+            return;
+        }
+        for (size_t i = 0; i < h.count; ++i) {
+            if (entries[i].slot < header().count) at(static_cast<size_t>(entries[i].slot)) = entries[i].record;
+        }
+        records.sync();
+        h.count = 0;
+        intent.sync(0, sizeof(IntentHeader));
+    }
+
+    bool writeIntent(MappedFile& intent) {
+        const size_t bytes = sizeof(IntentHeader) + staged.size() * sizeof(IntentEntry);
+        if (!intent.open(intentPath, true, true)) return false;
+        if (intent.size() < bytes && !intent.resize(bytes)) return false;
+        std::memcpy(intent.data() + sizeof(IntentHeader), staged.data(), staged.size() * sizeof(IntentEntry));
+        IntentHeader& h = *reinterpret_cast<IntentHeader*>(intent.data());
+        std::memcpy(h.magic, INTENT_MAGIC, sizeof(INTENT_MAGIC));
+        h.count = staged.size();
+        h.checksum = checksum(staged.data(), staged.size());
+        intent.sync(0, bytes);
+        return true;
+    }
+
+    bool grow() {
+        uint64_t newCapacity = header().capacity * 2;
+        if (!records.resize(sizeof(Header) + newCapacity * sizeof(Record))) return false;
+        header().capacity = newCapacity;
+        return true;
+    }
+
+public:
+    static std::string formatCardNumber(uint32_t card) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "%07u", card);
+        return buf;
+    }
+
+    static bool parseCardNumber(std::string_view card, uint32_t& out) {
+        if (card.empty() || card.size() > 9) return false;
+        uint32_t value = 0;
+        for (char c : card) {
+            if (c < '0' || c > '9') return false;
+            value = value * 10 + static_cast<uint32_t>(c - '0');
+        }
+        out = value;
+        return true;
+    }
+
+    static std::string readPin(const Record& rec) {
+        return std::string(rec.pin, std::find(rec.pin, rec.pin + sizeof(rec.pin), '\0'));
+    }
+
+    static int64_t toCents(double amount) { return static_cast<int64_t>(std::llround(amount * 100.0)); }
+    static double fromCents(int64_t cents) { return static_cast<double>(cents) / 100.0; }
+
+    bool open(const std::string& path, const std::string& namesFile) {
+        if (!records.open(path, true, true)) return false;
+        if (records.size() == 0) {
+            if (!records.resize(sizeof(Header) + INITIAL_CAPACITY * sizeof(Record))) return false;
+            Header& h = header();
+            std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+            h.version = VERSION;
+            h.recordSize = sizeof(Record);
+            h.count = 0;
+            h.capacity = INITIAL_CAPACITY;
+        }
+        if (records.size() < sizeof(Header)) return false;
+        const Header& h = header();
+        if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != VERSION ||
+            h.recordSize != sizeof(Record) ||
+            records.size() < sizeof(Header) + h.capacity * sizeof(Record)) {
+            records.close();
+            return false;
+        }
+
+        intentPath = path + ".intent";
+        staged.clear();
+        recoverIntent();
+
+        namesPath = namesFile;
+        namesOut.open(namesPath, std::ios::app | std::ios::binary);
+        namesOut.seekp(0, std::ios::end);
+        namesSize = static_cast<uint64_t>(namesOut.tellp());
+        namesMap.open(namesPath, false);
+        return true;
+    }
+
+    size_t size() const { return records.data() ? static_cast<size_t>(header().count) : 0; }
+    Record& at(size_t slot) { return recordBase()[slot]; }
+    const Record& at(size_t slot) const { return recordBase()[slot]; }
+
+    std::string readName(const Record& rec) {
+        if (rec.nameOffset + rec.nameLength > namesMap.size()) {
+            namesOut.flush();
+            namesMap.open(namesPath, false);
+        }
+        if (rec.nameLength == 0 || rec.nameOffset + rec.nameLength > namesMap.size()) return "Unknown";
+        return std::string(namesMap.data() + rec.nameOffset, rec.nameLength);
+    }
+
+    // Returns the new slot, or -1 if the file could not be grown.
+    long long append(const AccountRow& row) {
+        uint32_t card = 0;
+        if (!parseCardNumber(row.accountNumber, card)) return -1;
+        if (header().count == header().capacity && !grow()) return -1;
+
+        size_t slot = static_cast<size_t>(header().count);
+        Record& rec = at(slot);
+        std::memset(&rec, 0, sizeof(Record));
+        rec.cardNumber = card;
+        rec.type = (row.accountType == "Savings Account") ? TYPE_SAVINGS : TYPE_CHECKING;
+        rec.nameOffset = namesSize;
+        rec.nameLength = static_cast<uint16_t>(std::min<size_t>(row.holderName.size(), UINT16_MAX));
+        namesOut.write(row.holderName.data(), rec.nameLength);
+        namesSize += rec.nameLength;
+        update(slot, row.pin, row.balance, row.locked, row.failedAttempts);
+        header().count++;
+        return static_cast<long long>(slot);
+    }
+
+    void updateBalance(size_t slot, double balance) {
+        at(slot).balanceCents = toCents(balance);
+    }
+
+    // Writes a record in place at once; for files no one else relies on yet
+    // (see importCsv). Everything else goes through stage.
+    void update(size_t slot, std::string_view pin, double balance, bool locked, int failedAttempts) {
+        fillRecord(at(slot), pin, balance, locked, failedAttempts);
+    }
+
+    // Changes a record at the next sync, together with the rest of the group.
+    void stage(size_t slot, std::string_view pin, double balance, bool locked, int failedAttempts) {
+        IntentEntry entry{slot, at(slot)};
+        fillRecord(entry.record, pin, balance, locked, failedAttempts);
+        staged.push_back(entry);
+    }
+
+    // Writes the staged records and pushes everything to disk. If the intent
+    // file cannot be written the records are still copied, just without the
+    // crash protection.
+    void sync() {
+        namesOut.flush();
+        MappedFile intent;
+        const bool logged = staged.size() > 1 && writeIntent(intent);
+        for (const IntentEntry& entry : staged) at(static_cast<size_t>(entry.slot)) = entry.record;
+        staged.clear();
+        records.sync();
+        if (logged) {
+            reinterpret_cast<IntentHeader*>(intent.data())->count = 0;
+            intent.sync(0, sizeof(IntentHeader));
+        }
+    }
+
+    // Converts a CSV snapshot plus its journal into a binary store. The result
+    // is built under temporary names and renamed into place, so a running
+    // process keeps seeing either the old files or the complete new ones.
+    static bool importCsv(const std::string& csvPath, const std::string& journalPath,
+                          const std::string& binPath, const std::string& namesFile, size_t& imported) {
+        const std::string tmpBin = binPath + ".tmp";
+        const std::string tmpNames = namesFile + ".tmp";
+        std::remove(tmpBin.c_str());
+        std::remove(tmpNames.c_str());
+
+        imported = 0;
+        bool ok = true;
+        {
+            BinaryAccountStore out;
+            if (!out.open(tmpBin, tmpNames)) return false;
+            CardMap<size_t> slots;
+
+            auto upsert = [&](std::string_view line) {
+                AccountRow row;
+                uint32_t card = 0;
+                if (!ok || !parseAccountRow(line, row) || !parseCardNumber(row.accountNumber, card)) return;
+                if (const size_t* existing = slots.find(card)) {
+                    out.update(*existing, row.pin, row.balance, row.locked, row.failedAttempts);
+                    return;
+                }
+                long long slot = out.append(row);
+                if (slot < 0) {
+                    ok = false;
+                    return;
+                }
+                slots[card] = static_cast<size_t>(slot);
+            };
+
+            MappedFile csv;
+            if (csv.open(csvPath, false)) {
+                forEachLine(csv.data(), csv.size(), upsert);
+            }
+            AccountJournal(journalPath).replay([&](const std::string& line, uint64_t) { upsert(line); });
+
+            out.sync();
+            imported = out.size();
+        }
+
+        if (!ok) {
+            std::remove(tmpBin.c_str());
+            std::remove(tmpNames.c_str());
+            return false;
+        }
+        std::remove(namesFile.c_str());
+        std::remove(binPath.c_str());
+        std::remove((binPath + ".intent").c_str());
+        return std::rename(tmpNames.c_str(), namesFile.c_str()) == 0 &&
+               std::rename(tmpBin.c_str(), binPath.c_str()) == 0;
+    }
+};
+
+#endif // BINARYACCOUNTSTORE_H
@@ -0,0 +1,137 @@
+#ifndef CARDMAP_H
+#define CARDMAP_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+// Open-addressing hash table keyed by the integer card number. Keys live in
+// their own contiguous array, so a lookup is a multiplicative hash plus a
+// short linear probe over 4-byte keys (16 per cache line) and a single access
+// into the value array on a hit. Load is kept at or below 1/2, and deletion
+// shifts later entries back so probes never need tombstones.
+template <typename V>
+class CardMap {
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    std::vector<uint32_t> keys;
+    std::vector<V> values;
+    size_t count{0};
+    unsigned shift{32};
+
+    size_t home(uint32_t key) const {
+        // Fibonacci hashing: the top bits of key * 2^32/phi spread
+        // sequential card numbers evenly over the table.
+        return static_cast<size_t>((key * 2654435769u) >> shift);
+    }
+
+    size_t mask() const { return keys.size() - 1; }
+
+    size_t probe(uint32_t key) const {
+        size_t i = home(key);
+        while (keys[i] != key && keys[i] != EMPTY) i = (i + 1) & mask();
+        return i;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<uint32_t> oldKeys(capacity, EMPTY);
+        std::vector<V> oldValues(capacity);
+        oldKeys.swap(keys);
+        oldValues.swap(values);
+        shift = 32;
+        for (size_t c = capacity; c > 1; c >>= 1) --shift;
+        for (size_t i = 0; i < oldKeys.size(); ++i) {
+            if (oldKeys[i] == EMPTY) continue;
+            size_t slot = probe(oldKeys[i]);
+            keys[slot] = oldKeys[i];
+            values[slot] = std::move(oldValues[i]);
+        }
+    }
+
+    size_t capacityFor(size_t n) const {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < n * 2) capacity <<= 1;
+        return capacity;
+    }
+
+public:
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    void reserve(size_t n) {
+        size_t capacity = capacityFor(n);
+        if (capacity > keys.size()) rehash(capacity);
+    }
+
+    void clear() {
+        keys.clear();
+        values.clear();
+        count = 0;
+        shift = 32;
+    }
+
+    V* find(uint32_t key) {
+        if (count == 0) return nullptr;
+        size_t slot = probe(key);
+        return keys[slot] == EMPTY ? nullptr : &values[slot];
+    }
+
+    const V* find(uint32_t key) const {
+        if (count == 0) return nullptr;
+        size_t slot = probe(key);
+        return keys[slot] == EMPTY ? nullptr : &values[slot];
+    }
+
+    bool contains(uint32_t key) const { return find(key) != nullptr; }
+
+    // Inserts a default value if the key is absent.
+    V& operator[](uint32_t key) {
+        if ((count + 1) * 2 > keys.size()) rehash(capacityFor(count + 1));
+        size_t slot = probe(key);
+        if (keys[slot] == EMPTY) {
+            keys[slot] = key;
+            count++;
+        }
+        return values[slot];
+    }
+
+    bool erase(uint32_t key) {
+        if (count == 0) return false;
+        size_t hole = probe(key);
+        if (keys[hole] == EMPTY) return false;
+        // Backward-shift deletion: an entry later in the cluster moves into
+        // the hole if it is at least as far from its home slot as the hole is.
+        for (size_t i = (hole + 1) & mask(); keys[i] != EMPTY; i = (i + 1) & mask()) {
+            size_t displacement = (i - home(keys[i])) & mask();
+            if (displacement >= ((i - hole) & mask())) {
+                keys[hole] = keys[i];
+                values[hole] = std::move(values[i]);
+                hole = i;
+            }
+        }
+        keys[hole] = EMPTY;
+        values[hole] = V();
+        count--;
+        return true;
+    }
+
+    // Visits entries in table order, fn(key, value).
+    template <typename Fn>
+    void forEach(Fn&& fn) {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i] != EMPTY) fn(keys[i], values[i]);
+        }
+    }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i] != EMPTY) fn(keys[i], values[i]);
+        }
+    }
+};
+
+#endif // CARDMAP_H
@@ -4,27 +4,26 @@
 #include "Account.h"
 
 class CheckingAccount : public Account {
-private:
-    double overdraftLimit;
-
 public:
-    CheckingAccount(const std::string& accNum, const std::string& pinCode, 
-                    double initialBalance = 0.0, double overdraft = 500.0)
-        : Account(accNum, pinCode, initialBalance), overdraftLimit(overdraft) {}
+    static constexpr double DEFAULT_OVERDRAFT_LIMIT = AccountTable::DEFAULT_OVERDRAFT_LIMIT_CENTS / 100.0;
+    // Charged by the end-of-day run to accounts left below zero.
+    static constexpr double DEFAULT_OVERDRAFT_FEE = 25.0;
+
+    CheckingAccount(AccountTable& accountTable, size_t tableRow) : Account(accountTable, tableRow) {}
 
     std::string displayAccountType() const override {
         return "Checking Account";
     }
 
     bool withdraw(double amount) override {
-        if (amount > 0 && (balance + overdraftLimit) >= amount) {
-            balance -= amount;
-            return true;
+        if (amount > 0) {
+            // may go down to -overdraftLimit, which lives in the row
+            return table.adjustBalance(row, -AccountTable::toCents(amount), -table.overdraftLimitCents(row));
         }
         return false;
     }
 
-    double getOverdraftLimit() const { return overdraftLimit; }
+    double getOverdraftLimit() const { return AccountTable::fromCents(table.overdraftLimitCents(row)); }
 };
 
 #endif // CHECKINGACCOUNT_H
\ No newline at end of file
@@ -3,26 +3,12 @@
 
 #include "Transaction.h"
 
+// A Transaction tagged Deposit; adds no state, so it can be stored as a
+// plain Transaction.
 class DepositTransaction : public Transaction {
 public:
-    DepositTransaction(const std::string& transID, const std::string& accNum, double amt)
-        : Transaction(transID, accNum, amt) {}
-
-    std::string printReceipt() const override {
-        std::stringstream ss;
-        ss << "========== DEPOSIT RECEIPT ==========\n";
-        ss << "Transaction ID: " << transactionID << "\n";
-        ss << "Account Number: " << accountNumber << "\n";
-        ss << "Type: DEPOSIT\n";
-        ss << "Amount: $" << std::fixed << std::setprecision(2) << amount << "\n";
-        ss << "Date/Time: " << timestamp << "\n";
-        ss << "=====================================\n";
-        return ss.str();
-    }
-
-    std::string getType() const override {
-        return "DEPOSIT";
-    }
+    DepositTransaction(uint64_t transID, const std::string& accNum, double amt)
+        : Transaction(Type::Deposit, transID, accNum, amt) {}
 };
 
 #endif // DEPOSITTRANSACTION_H
\ No newline at end of file
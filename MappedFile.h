@@ -0,0 +1,180 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_WIN32) || defined(_WIN64)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Thin RAII wrapper around a memory-mapped file (mmap on POSIX, file mappings
+// on Windows). Writable mappings are shared, so stores land in the page cache
+// immediately and survive a process crash; sync() pushes them to disk.
+class MappedFile {
+private:
+    char* base{nullptr};
+    size_t length{0};
+    bool writable{false};
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE fileHandle{INVALID_HANDLE_VALUE};
+    HANDLE mappingHandle{nullptr};
+#else
+    int fd{-1};
+#endif
+
+    bool map() {
+        if (length == 0) return true; // empty files cannot be mapped
+#if defined(_WIN32) || defined(_WIN64)
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                           0, 0, nullptr);
+        if (!mappingHandle) return false;
+        void* view = MapViewOfFile(mappingHandle, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, length);
+        if (!view) return false;
+        base = static_cast<char*>(view);
+#else
+        void* view = mmap(nullptr, length, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED) return false;
+        base = static_cast<char*>(view);
+#endif
+        return true;
+    }
+
+    void unmap() {
+#if defined(_WIN32) || defined(_WIN64)
+        if (base) UnmapViewOfFile(base);
+        if (mappingHandle) CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+#else
+        if (base) munmap(base, length);
+#endif
+        base = nullptr;
+    }
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path, bool forWriting, bool create = false) {
+        close();
+        writable = forWriting;
+#if defined(_WIN32) || defined(_WIN64)
+        fileHandle = CreateFileA(path.c_str(), forWriting ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                 create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(fileHandle, &size)) { close(); return false; }
+        length = static_cast<size_t>(size.QuadPart);
+#else
+        int flags = forWriting ? O_RDWR : O_RDONLY;
+        if (create) flags |= O_CREAT;
+        fd = ::open(path.c_str(), flags, 0644);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { close(); return false; }
+        length = static_cast<size_t>(st.st_size);
+#endif
+        if (!map()) { close(); return false; }
+        return true;
+    }
+
+    // Grows or shrinks the file and remaps it. Pointers into the old mapping
+    // are invalidated.
+    bool resize(size_t newLength) {
+        if (!writable) return false;
+        unmap();
+#if defined(_WIN32) || defined(_WIN64)
+        LARGE_INTEGER pos;
+        pos.QuadPart = static_cast<LONGLONG>(newLength);
+        if (!SetFilePointerEx(fileHandle, pos, nullptr, FILE_BEGIN) || !SetEndOfFile(fileHandle)) return false;
+#else
+        if (ftruncate(fd, static_cast<off_t>(newLength)) != 0) return false;
+#endif
+        length = newLength;
+        return map();
+    }
+
+    void sync(size_t offset = 0, size_t bytes = 0) {
+        if (!base || !writable) return;
+        if (bytes == 0) bytes = length - offset;
+#if defined(_WIN32) || defined(_WIN64)
+        FlushViewOfFile(base + offset, bytes);
+        FlushFileBuffers(fileHandle);
+#else
+        // msync wants a page-aligned start address
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t alignedStart = offset - (offset % page);
+        msync(base + alignedStart, bytes + (offset - alignedStart), MS_SYNC);
+#endif
+    }
+
+    void close() {
+        unmap();
+#if defined(_WIN32) || defined(_WIN64)
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        length = 0;
+    }
+
+    bool isOpen() const {
+#if defined(_WIN32) || defined(_WIN64)
+        return fileHandle != INVALID_HANDLE_VALUE;
+#else
+        return fd >= 0;
+#endif
+    }
+
+    // fsync for files written through a stream: pushes path's data to disk.
+    static bool syncFile(const std::string& path) {
+#if defined(_WIN32) || defined(_WIN64)
+        HANDLE handle = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) return false;
+        bool synced = FlushFileBuffers(handle) != 0;
+        CloseHandle(handle);
+#else
+        int file = ::open(path.c_str(), O_WRONLY);
+        if (file < 0) return false;
+        bool synced = ::fsync(file) == 0;
+        ::close(file);
+#endif
+        return synced;
+    }
+
+    // Makes a rename or a new file in dir durable. NTFS journals its
+    // directories itself, so this is a no-op on Windows.
+    static bool syncDirectory(const std::string& dir) {
+#if defined(_WIN32) || defined(_WIN64)
+        (void)dir;
+        return true;
+#else
+        int file = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+        if (file < 0) return false;
+        bool synced = ::fsync(file) == 0;
+        ::close(file);
+        return synced;
+#endif
+    }
+
+    char* data() { return base; }
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+};
+
+#endif // MAPPEDFILE_H
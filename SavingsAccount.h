@@ -8,18 +8,13 @@ private:
     double interestRate;
 
 public:
-    SavingsAccount(const std::string& accNum, const std::string& pinCode, 
-                   double initialBalance = 0.0, double rate = 0.015)
-        : Account(accNum, pinCode, initialBalance), interestRate(rate) {}
+    SavingsAccount(AccountTable& accountTable, size_t tableRow, double rate = 0.015)
+        : Account(accountTable, tableRow), interestRate(rate) {}
 
     std::string displayAccountType() const override {
         return "Savings Account";
     }
 
-    void applyInterest(double rate) override {
-        balance += balance * rate;
-    }
-
     double getInterestRate() const { return interestRate; }
 };
 
@@ -0,0 +1,107 @@
+#ifndef TIMEFORMAT_H
+#define TIMEFORMAT_H
+
+#include <string>
+#include <string_view>
+#include <ctime>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+// Conversions between epoch milliseconds and the local "YYYY-MM-DD HH:MM:SS"
+// text used on receipts and in the log. Both directions cache the last hour
+// they resolved per thread (time zone offsets only change on hour
+// boundaries): parsing reuses its epoch, formatting its text and only
+// rewrites minutes and seconds, so neither calls into the time zone code for
+// timestamps within the same hour.
+class TimeFormat {
+private:
+    static int digits(const char* p, int n) {
+        int value = 0;
+        for (int i = 0; i < n; ++i) {
+            if (p[i] < '0' || p[i] > '9') return -1;
+            value = value * 10 + (p[i] - '0');
+        }
+        return value;
+    }
+
+    static void toLocal(time_t seconds, std::tm& out) {
+#if defined(_WIN32) || defined(_WIN64)
+        localtime_s(&out, &seconds);
+#else
+        localtime_r(&seconds, &out);
+#endif
+    }
+
+public:
+    static constexpr size_t TEXT_LENGTH = 19;
+
+    // Accepts exactly "YYYY-MM-DD HH:MM:SS".
+    static bool parse(std::string_view text, int64_t& epochMs) {
+        if (text.size() != TEXT_LENGTH || text[4] != '-' || text[7] != '-' || text[10] != ' ' ||
+            text[13] != ':' || text[16] != ':') {
+            return false;
+        }
+        const char* p = text.data();
+        int minute = digits(p + 14, 2);
+        int second = digits(p + 17, 2);
+        if (minute < 0 || minute > 59 || second < 0 || second > 60) return false;
+
+        thread_local char cachedHour[13] = {};
+        thread_local int64_t cachedHourSeconds = 0;
+        if (std::memcmp(cachedHour, p, sizeof(cachedHour)) != 0) {
+            int year = digits(p, 4);
+            int month = digits(p + 5, 2);
+            int day = digits(p + 8, 2);
+            int hour = digits(p + 11, 2);
+            if (year < 1970 || month < 1 || month > 12 || day < 1 || day > 31 || hour < 0 || hour > 23) return false;
+            std::tm fields{};
+            fields.tm_year = year - 1900;
+            fields.tm_mon = month - 1;
+            fields.tm_mday = day;
+            fields.tm_hour = hour;
+            fields.tm_isdst = -1;
+            time_t seconds = std::mktime(&fields);
+            if (seconds == static_cast<time_t>(-1)) return false;
+            std::memcpy(cachedHour, p, sizeof(cachedHour));
+            cachedHourSeconds = static_cast<int64_t>(seconds);
+        }
+        epochMs = (cachedHourSeconds + minute * 60 + second) * 1000;
+        return true;
+    }
+
+    static std::string format(int64_t epochMs) {
+        int64_t seconds = epochMs >= 0 ? epochMs / 1000 : (epochMs - 999) / 1000;
+        thread_local bool cached = false;
+        thread_local int64_t cachedHourStart = 0;
+        thread_local char cachedText[TEXT_LENGTH + 1] = {};
+        if (!cached || seconds < cachedHourStart || seconds - cachedHourStart >= 3600) {
+            std::tm fields{};
+            toLocal(static_cast<time_t>(seconds), fields);
+            std::strftime(cachedText, sizeof(cachedText), "%Y-%m-%d %H:%M:%S", &fields);
+            cachedHourStart = seconds - fields.tm_min * 60 - fields.tm_sec;
+            cached = true;
+        }
+        int within = static_cast<int>(seconds - cachedHourStart);
+        cachedText[14] = static_cast<char>('0' + within / 600);
+        cachedText[15] = static_cast<char>('0' + within / 60 % 10);
+        cachedText[17] = static_cast<char>('0' + within % 60 / 10);
+        cachedText[18] = static_cast<char>('0' + within % 10);
+        return std::string(cachedText, TEXT_LENGTH);
+    }
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Local calendar day as YYYYMMDD.
+    static int day(int64_t epochMs) {
+        int64_t seconds = epochMs >= 0 ? epochMs / 1000 : (epochMs - 999) / 1000;
+        std::tm fields{};
+        toLocal(static_cast<time_t>(seconds), fields);
+        return (fields.tm_year + 1900) * 10000 + (fields.tm_mon + 1) * 100 + fields.tm_mday;
+    }
+};
+
+#endif // TIMEFORMAT_H
@@ -2,40 +2,85 @@
 #define TRANSACTION_H
 
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <iomanip>
-#include <ctime>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "TimeFormat.h"
+#include "TransactionIdGenerator.h"
 
+// One deposit, withdrawal or transfer as a plain value: a type tag and
+// fixed-size fields, so it is copied into account histories and the log
+// queue without touching the heap. Receipts and type names come from the
+// tag. The time is kept as epoch milliseconds and only formatted for
+// display. Longer fields are truncated.
 class Transaction {
-protected:
-    std::string transactionID;
-    std::string accountNumber;
+public:
+    enum class Type : uint8_t { Deposit, Withdrawal, Transfer };
+
+private:
+    Type type;
+    uint64_t transactionID;
+    char accountNumber[16];
+    char counterparty[16]; // recipient of a transfer; empty otherwise
+    int64_t timestampMs;
     double amount;
-    std::string timestamp;
 
-    std::string getCurrentTimestamp() {
-        time_t now = time(0);
-        char buf[80];
-        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", localtime(&now));
-        return std::string(buf);
+    template <size_t N>
+    static void copyField(char (&field)[N], std::string_view value) {
+        size_t n = std::min(value.size(), N - 1);
+        if (n > 0) std::memcpy(field, value.data(), n);
+        field[n] = '\0';
     }
 
 public:
-    Transaction(const std::string& transID, const std::string& accNum, double amt)
-        : transactionID(transID), accountNumber(accNum), amount(amt) {
-        timestamp = getCurrentTimestamp();
+    Transaction(Type transType, uint64_t transID, const std::string& accNum, double amt,
+                const std::string& recipient = "")
+        : type(transType), transactionID(transID), timestampMs(TimeFormat::now()), amount(amt) {
+        copyField(accountNumber, accNum);
+        copyField(counterparty, recipient);
+    }
+
+    std::string printReceipt() const {
+        std::stringstream ss;
+        switch (type) {
+        case Type::Deposit:     ss << "========== DEPOSIT RECEIPT ==========\n"; break;
+        case Type::Withdrawal:  ss << "======== WITHDRAWAL RECEIPT =========\n"; break;
+        case Type::Transfer:    ss << "========= TRANSFER RECEIPT ==========\n"; break;
+        }
+        ss << "Transaction ID: " << getTransactionID() << "\n";
+        ss << "Account Number: " << accountNumber << "\n";
+        if (type == Type::Transfer) ss << "Recipient: " << counterparty << "\n";
+        ss << "Type: " << getType() << "\n";
+        ss << "Amount: $" << std::fixed << std::setprecision(2) << amount << "\n";
+        ss << "Date/Time: " << getTimestamp() << "\n";
+        ss << "=====================================\n";
+        return ss.str();
     }
 
-    virtual ~Transaction() = default;
+    // The name used in the transaction log.
+    std::string_view getType() const {
+        switch (type) {
+        case Type::Deposit:     return "DEPOSIT";
+        case Type::Withdrawal:  return "WITHDRAWAL";
+        case Type::Transfer:    return "TRANSFER";
+        }
+        return "";
+    }
 
-    // Pure virtual function for polymorphism
-    virtual std::string printReceipt() const = 0;
-    virtual std::string getType() const = 0;
-    
-    std::string getTransactionID() const { return transactionID; }
-    std::string getAccountNumber() const { return accountNumber; }
+    Type getTransactionType() const { return type; }
+    uint64_t getID() const { return transactionID; }
+    std::string getTransactionID() const { return TransactionIdGenerator::toText(transactionID); }
+    std::string_view getAccountNumber() const { return accountNumber; }
+    std::string_view getCounterparty() const { return counterparty; }
     double getAmount() const { return amount; }
-    std::string getTimestamp() const { return timestamp; }
+    int64_t getTimestampMs() const { return timestampMs; }
+    std::string getTimestamp() const { return TimeFormat::format(timestampMs); }
 };
 
+static_assert(std::is_trivially_copyable<Transaction>::value, "Transaction is copied as plain bytes");
+
 #endif // TRANSACTION_H
@@ -0,0 +1,120 @@
+#ifndef TRANSACTIONIDGENERATOR_H
+#define TRANSACTIONIDGENERATOR_H
+
+#include <string>
+#include <fstream>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdint>
+#include "TimeFormat.h"
+
+// Snowflake-style 64-bit transaction ids: milliseconds since EPOCH_MS in the
+// high 41 bits, the ATM's node id in the next 10 and a sequence number in the
+// low 12. Ids from one generator strictly increase; ATMs with different node
+// ids never share one. Receipts and the log's text form show an id as
+// "TXN<n>".
+//
+// next() is a compare-and-swap on the last issued (time, sequence) pair, so
+// threads never wait for each other. More than 4096 ids in one millisecond
+// borrow sequence numbers from the next millisecond rather than waiting for
+// the clock, and a clock that steps back is ignored until it catches up.
+//
+// Uniqueness across restarts comes from a lease kept in ID_FILE_PREFIX +
+// node + ".dat": ids are only issued below the leased time, which is pushed
+// LEASE_MS ahead whenever it runs out, and a restarted generator starts at
+// the lease. The file is written at most once per LEASE_MS of issued ids.
+// A node id above MAX_NODE is refused (std::out_of_range) rather than
+// folded onto another ATM's ids.
+class TransactionIdGenerator {
+public:
+    static inline const std::string ID_FILE_PREFIX = "transaction_ids_";
+    static constexpr int SEQUENCE_BITS = 12;
+    static constexpr int NODE_BITS = 10;
+    static constexpr uint32_t MAX_NODE = (1u << NODE_BITS) - 1;
+    // Taken by --batch-transfer runs, so ATMs use 0 to BATCH_NODE - 1.
+    static constexpr uint32_t BATCH_NODE = MAX_NODE;
+    static constexpr int64_t EPOCH_MS = 1704067200000; // 2024-01-01 00:00:00 UTC
+    static constexpr int64_t LEASE_MS = 10000;
+
+private:
+    static constexpr uint64_t SEQUENCE_MASK = (uint64_t(1) << SEQUENCE_BITS) - 1;
+
+    std::string leaseFile;
+    uint64_t nodeBits;
+    // Epoch milliseconds; TimeFormat::now unless a test steps the clock.
+    int64_t (*now)();
+    // (ms since EPOCH_MS << SEQUENCE_BITS) | sequence of the last issued id.
+    std::atomic<uint64_t> last{0};
+    // Ids are issued only below this many ms since EPOCH_MS.
+    std::atomic<int64_t> leasedUntil{0};
+    std::mutex leaseLock;
+
+    int64_t clock() const { return std::max<int64_t>(now() - EPOCH_MS, 0); }
+
+    static uint32_t checkedNode(uint32_t node) {
+        if (node > MAX_NODE) {
+            throw std::out_of_range("transaction id node " + std::to_string(node) + " is above " +
+                                    std::to_string(MAX_NODE));
+        }
+        return node;
+    }
+
+    void extendLease(int64_t ms) {
+        std::lock_guard<std::mutex> guard(leaseLock);
+        if (ms < leasedUntil.load(std::memory_order_relaxed)) return;
+        int64_t until = ms + LEASE_MS;
+        std::string tmpFile = leaseFile + ".tmp";
+        {
+            std::ofstream file(tmpFile, std::ios::trunc);
+            file << until << "\n";
+        }
+        if (std::rename(tmpFile.c_str(), leaseFile.c_str()) != 0) {
+            // Windows will not rename over an existing file
+            std::remove(leaseFile.c_str());
+            std::rename(tmpFile.c_str(), leaseFile.c_str());
+        }
+        leasedUntil.store(until, std::memory_order_release);
+    }
+
+public:
+    explicit TransactionIdGenerator(uint32_t node = 0, int64_t (*clockMs)() = TimeFormat::now)
+        : leaseFile(ID_FILE_PREFIX + std::to_string(checkedNode(node)) + ".dat"),
+          nodeBits(static_cast<uint64_t>(node) << SEQUENCE_BITS),
+          now(clockMs) {
+        int64_t leased = 0;
+        std::ifstream file(leaseFile);
+        if (!(file >> leased) || leased < 0) leased = 0;
+        int64_t start = std::max(leased, clock());
+        last.store(static_cast<uint64_t>(start) << SEQUENCE_BITS);
+        leasedUntil.store(start);
+    }
+
+    TransactionIdGenerator(const TransactionIdGenerator&) = delete;
+    TransactionIdGenerator& operator=(const TransactionIdGenerator&) = delete;
+
+    uint64_t next() {
+        const uint64_t now = static_cast<uint64_t>(clock()) << SEQUENCE_BITS;
+        uint64_t previous = last.load(std::memory_order_relaxed);
+        uint64_t issued;
+        do {
+            issued = std::max(previous + 1, now);
+        } while (!last.compare_exchange_weak(previous, issued, std::memory_order_relaxed));
+        const int64_t ms = static_cast<int64_t>(issued >> SEQUENCE_BITS);
+        if (ms >= leasedUntil.load(std::memory_order_acquire)) extendLease(ms);
+        return (issued >> SEQUENCE_BITS) << (SEQUENCE_BITS + NODE_BITS) | nodeBits | (issued & SEQUENCE_MASK);
+    }
+
+    uint32_t node() const { return static_cast<uint32_t>(nodeBits >> SEQUENCE_BITS); }
+
+    // Milliseconds since the Unix epoch encoded in an id.
+    static int64_t timestampOf(uint64_t id) {
+        return static_cast<int64_t>(id >> (SEQUENCE_BITS + NODE_BITS)) + EPOCH_MS;
+    }
+
+    static std::string toText(uint64_t id) { return "TXN" + std::to_string(id); }
+};
+
+#endif // TRANSACTIONIDGENERATOR_H
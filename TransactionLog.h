@@ -7,65 +7,1065 @@
 #include <sstream>
 #include <iomanip>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include "AccountRow.h"
+#include "MappedFile.h"
+#include "MpscRing.h"
+#include "TransactionLogIndex.h"
+#include "TransactionSegment.h"
 #include "Transaction.h"
 
+// A logged transaction as readers return it: fixed-size, with no heap
+// storage; the accessors produce the text shown on screen. Fields the log
+// had to keep as text because they fit no compact encoding (see
+// TransactionSegment.h) read as empty. Reads for one account return a
+// transfer as that account's leg, TRANSFER_OUT or TRANSFER_IN, with the other
+// side as counterparty.
 struct TransactionRecord {
-    std::string transactionID;
-    std::string accountNumber;
-    std::string type;
-    double amount;
-    std::string timestamp;
+    uint64_t id{0};          // n of "TXN<n>"; 0 if unknown
+    uint32_t account{0};
+    uint32_t counterparty{0}; // transfers only
+    uint8_t accountDigits{0}; // 0 if unknown
+    uint8_t counterpartyDigits{0};
+    uint8_t type{TransactionSegment::TYPE_TEXT};
+    int64_t amountCents{0};
+    int64_t timestampMs{INT64_MIN}; // INT64_MIN if unknown
+
+    std::string transactionID() const { return id == 0 ? std::string() : "TXN" + std::to_string(id); }
+    std::string accountNumber() const { return TransactionSegment::accountText(account, accountDigits); }
+    std::string counterpartyNumber() const { return TransactionSegment::accountText(counterparty, counterpartyDigits); }
+    std::string_view typeName() const { return TransactionSegment::typeName(type); }
+    double amount() const { return static_cast<double>(amountCents) / 100.0; }
+    std::string timestamp() const { return timestampMs == INT64_MIN ? std::string() : TimeFormat::format(timestampMs); }
 };
+static_assert(sizeof(TransactionRecord) == 40, "TransactionRecord is meant to stay compact");
 
 class TransactionLog {
+public:
+    // When drained records reach the file: after every record, once
+    // flushEveryRecords have accumulated, or once flushIntervalMs has passed
+    // since the last write. flushIntervalMs also caps how long any record
+    // waits, and a block of maxBufferBytes is written regardless.
+    enum class FlushPolicy { EveryRecord, EveryNRecords, Interval };
+
+    struct Options {
+        FlushPolicy policy = FlushPolicy::EveryNRecords;
+        size_t flushEveryRecords = 64;
+        long long flushIntervalMs = 200;
+        size_t maxBufferBytes = 64 * 1024;
+        // The live segment is sealed and a new one started when a record
+        // from a later day arrives (rotateDaily) or the segment would grow past
+        // maxSegmentBytes (0 = no cap).
+        bool rotateDaily = true;
+        uint64_t maxSegmentBytes = 64ull * 1024 * 1024;
+    };
+
+    struct Stats {
+        uint64_t enqueued{0};
+        uint64_t written{0};        // on disk and flushed
+        uint64_t backpressureWaits{0}; // appends that found the queue full
+        size_t queueDepth{0};
+        size_t maxQueueDepth{0};
+        size_t queueCapacity{0};
+    };
+
 private:
-    static inline const std::string LOG_FILE = "transaction_log.csv";
+    // The live segment; sealed segments are moved to SEGMENT_DIR.
+    static inline const std::string LOG_FILE = "transaction_log.bin";
+    static inline const std::string INDEX_FILE = "transaction_log.idx";
+    static inline const std::string SEGMENT_DIR = "transaction_log_segments";
+    static inline const std::string ARCHIVE_DIR = "transaction_log_archive";
+    // Text log of earlier versions, imported once when LOG_FILE is created.
+    static inline const std::string LEGACY_LOG_FILE = "transaction_log.csv";
+    static constexpr size_t QUEUE_CAPACITY = 4096;
+
+    // One record's fields in fixed-size storage, so enqueueing never
+    // allocates. Longer fields are truncated.
+    struct QueuedRecord {
+        uint64_t id;
+        // Imported id text, which may not be of the form "TXN<n>"; empty
+        // when id is set.
+        char transactionID[24];
+        char accountNumber[16];
+        char type[16];
+        char counterparty[16]; // recipient of a TRANSFER
+        int64_t timestampMs;
+        // Imported text TimeFormat cannot parse; empty otherwise.
+        char timestampText[24];
+        double amount;
+    };
+
+    struct SealedSegment {
+        std::string path;
+        TransactionSegment::SegmentHeader header;
+    };
+
+    // Callers push records into a lock-free ring; a background thread
+    // drains it into a block (see TransactionSegment.h) and appends that to
+    // the log file, which it keeps open, then appends index entries for the
+    // block. When the live segment is due for rotation it is sealed and moved
+    // to SEGMENT_DIR first. The destructor drains and writes whatever is left
+    // at exit.
+    struct Writer {
+        MpscRing<QueuedRecord> queue{QUEUE_CAPACITY};
+        std::atomic<uint64_t> backpressureWaits{0};
+        std::atomic<size_t> maxQueueDepth{0};
+        std::atomic<bool> idle{false};
+
+        std::mutex lock; // options, stopping, flushWaiters, durable
+        std::condition_variable wake;
+        std::condition_variable drained;
+        Options options;
+        bool stopping{false};
+        size_t flushWaiters{0};
+        uint64_t durable{0};
+
+        TransactionLogIndex index{LOG_FILE, INDEX_FILE};
+
+        // Sealed segments, oldest first. Readers hold rotation shared while
+        // they read segment files; sealing and archiving hold it exclusively.
+        std::shared_mutex rotation;
+        std::vector<SealedSegment> segments;
+
+        // Offset of every block in the live segment, in order, and the
+        // records in them; updated by the writer thread once a block is in
+        // the file.
+        std::mutex blocksLock;
+        std::vector<uint64_t> liveBlocks;
+        uint64_t liveRecords{0};
+
+        // Writer thread only (and the constructor, before it starts).
+        std::ofstream out;
+        uint64_t logSize{0};
+        uint64_t segmentId{0};
+        TransactionSegment::SegmentStats liveStats;
+        TransactionSegment::SegmentStats blockStats;
+        TransactionSegment::BlockBuilder block;
+        std::vector<TransactionLogIndex::Entry> blockEntries;
+        std::string encoded;
+        uint64_t popped{0};
+        std::chrono::steady_clock::time_point lastWrite{std::chrono::steady_clock::now()};
+
+        std::thread thread;
+
+        Writer() {
+            loadSegments();
+            bool created = openLog();
+            thread = std::thread([this] { run(); });
+            size_t imported = 0;
+            if (created && segments.empty()) importFile(LEGACY_LOG_FILE, imported);
+        }
+
+        ~Writer() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            wake.notify_one();
+            thread.join();
+        }
+
+        void wakeWriter() {
+            // Taking the lock orders this with the writer's last check of
+            // the queue before it sleeps.
+            { std::lock_guard<std::mutex> guard(lock); }
+            wake.notify_one();
+        }
+
+        // Any thread. If the queue is full the caller waits for the writer
+        // to make room (counted in Stats::backpressureWaits).
+        void enqueue(const QueuedRecord& record) {
+            if (!queue.tryPush(record)) {
+                backpressureWaits++;
+                do {
+                    wakeWriter();
+                    std::this_thread::yield();
+                } while (!queue.tryPush(record));
+            }
+            size_t depth = queue.size();
+            size_t deepest = maxQueueDepth.load(std::memory_order_relaxed);
+            while (depth > deepest && !maxQueueDepth.compare_exchange_weak(deepest, depth, std::memory_order_relaxed)) {
+            }
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (idle.load()) wakeWriter();
+        }
+
+        // Queues every record of a CSV log (id,account,type,amount,timestamp
+        // lines, then the recipient for a TRANSFER). Malformed lines are
+        // skipped.
+        bool importFile(const std::string& path, size_t& imported) {
+            MappedFile csv;
+            if (!csv.open(path, false)) return false;
+            forEachLine(csv.data(), csv.size(), [&](std::string_view line) {
+                if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+                std::string_view rest = line;
+                QueuedRecord record;
+                record.id = 0;
+                copyField(record.transactionID, nextField(rest));
+                copyField(record.accountNumber, nextField(rest));
+                copyField(record.type, nextField(rest));
+                std::string_view amount = nextField(rest);
+                std::string_view timestamp = nextField(rest);
+                record.timestampMs = 0;
+                if (TimeFormat::parse(timestamp, record.timestampMs)) timestamp = std::string_view();
+                copyField(record.timestampText, timestamp);
+                copyField(record.counterparty, nextField(rest));
+                if (record.transactionID[0] == '\0' || !parseAmount(amount, record.amount)) return;
+                enqueue(record);
+                imported++;
+            });
+            return true;
+        }
+
+        static bool readSealedHeader(const std::string& path, TransactionSegment::SegmentHeader& header) {
+            MappedFile file;
+            return file.open(path, false) && TransactionSegment::readHeader(file.data(), file.size(), header) &&
+                   (header.flags & TransactionSegment::SEALED);
+        }
+
+        void loadSegments() {
+            std::error_code error;
+            std::filesystem::directory_iterator it(SEGMENT_DIR, error), end;
+            for (; !error && it != end; it.increment(error)) {
+                if (it->path().extension() != ".seg") continue;
+                SealedSegment segment{it->path().string(), {}};
+                if (readSealedHeader(segment.path, segment.header)) segments.push_back(segment);
+            }
+            std::sort(segments.begin(), segments.end(),
+                      [](const SealedSegment& a, const SealedSegment& b) { return a.path < b.path; });
+        }
+
+        static uint64_t newSegmentId() {
+            std::random_device device;
+            uint64_t id = (static_cast<uint64_t>(device()) << 32) ^ device();
+            return id ^ static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+        }
+
+        static bool writeHeader(const TransactionSegment::SegmentHeader& header) {
+            std::fstream file(LOG_FILE, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(sizeof(TransactionSegment::FILE_MAGIC));
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.flush();
+            return file.good();
+        }
+
+        // Moves the sealed live file to SEGMENT_DIR, named after the day of
+        // its first record, and adds it to segments.
+        bool moveSealed(const TransactionSegment::SegmentHeader& header) {
+            std::error_code error;
+            std::filesystem::create_directories(SEGMENT_DIR, error);
+            int day = header.minTimestampMs <= header.maxTimestampMs ? TimeFormat::day(header.minTimestampMs) : 0;
+            std::string path;
+            char name[32];
+            for (int sequence = 0;; ++sequence) {
+                std::snprintf(name, sizeof(name), "/%08d-%03d.seg", day, sequence);
+                path = SEGMENT_DIR + name;
+                if (!std::filesystem::exists(path, error)) break;
+            }
+            std::filesystem::rename(LOG_FILE, path, error);
+            if (error) return false;
+            segments.push_back(SealedSegment{path, header});
+            return true;
+        }
+
+        // Undoes a seal that could not be completed; the file stays live.
+        static void unseal(TransactionSegment::SegmentHeader header) {
+            std::error_code error;
+            std::filesystem::resize_file(LOG_FILE, header.accountTableOffset, error);
+            header.flags &= ~(TransactionSegment::SEALED | TransactionSegment::BLOCK_TABLE);
+            writeHeader(header);
+        }
+
+        void createLog() {
+            segmentId = newSegmentId();
+            liveStats = TransactionSegment::SegmentStats();
+            std::string header = TransactionSegment::newFile(segmentId);
+            out.open(LOG_FILE, std::ios::trunc | std::ios::binary);
+            out.write(header.data(), static_cast<std::streamsize>(header.size()));
+            out.flush();
+            logSize = header.size();
+            std::lock_guard<std::mutex> guard(blocksLock);
+            liveBlocks.clear();
+            liveRecords = 0;
+        }
+
+        // Checks the log before anything is appended: a block torn by a
+        // crash mid-write is cut off, a segment sealed but not yet moved is
+        // moved, and a file that is not a log at all is set aside. Returns
+        // true if a new log was created.
+        bool openLog() {
+            std::error_code error;
+            TransactionSegment::SegmentHeader header{};
+            bool exists = false;
+            bool sealed = false;
+            size_t validEnd = 0;
+            size_t fileSize = 0;
+            {
+                MappedFile existing;
+                if (existing.open(LOG_FILE, false) && existing.size() > 0) {
+                    fileSize = existing.size();
+                    if (!TransactionSegment::readHeader(existing.data(), fileSize, header)) {
+                        existing.close();
+                        std::filesystem::rename(LOG_FILE, LOG_FILE + ".unreadable", error);
+                    } else if (header.flags & TransactionSegment::SEALED) {
+                        exists = sealed = true;
+                    } else {
+                        exists = true;
+                        std::vector<uint64_t> blocks;
+                        validEnd = TransactionSegment::forEachBlock(existing.data(), fileSize, 0,
+                            [&blocks](uint64_t offset, const char*, size_t) { blocks.push_back(offset); });
+                        if (!blocks.empty() &&
+                            TransactionSegment::blockBytes(existing.data() + blocks.back(), validEnd - blocks.back(), true) == 0) {
+                            validEnd = static_cast<size_t>(blocks.back());
+                            blocks.pop_back();
+                        }
+                        std::vector<TransactionSegment::Row> rows;
+                        liveStats = TransactionSegment::SegmentStats();
+                        TransactionSegment::forEachBlock(existing.data(), validEnd, 0, [&](uint64_t, const char* data, size_t bytes) {
+                            if (!TransactionSegment::decode(data, bytes, rows)) return;
+                            for (const TransactionSegment::Row& row : rows) liveStats.add(row);
+                        });
+                        std::lock_guard<std::mutex> guard(blocksLock);
+                        liveBlocks.swap(blocks);
+                        liveRecords = liveStats.recordCount;
+                    }
+                }
+            }
+            if (sealed) {
+                // Crashed between sealing the live file and moving it.
+                if (moveSealed(header)) {
+                    createLog();
+                    return true;
+                }
+                unseal(header);
+                return openLog();
+            }
+            if (!exists) {
+                createLog();
+                return true;
+            }
+            if (validEnd < fileSize) std::filesystem::resize_file(LOG_FILE, validEnd, error);
+            segmentId = header.segmentId;
+            out.open(LOG_FILE, std::ios::app | std::ios::binary);
+            logSize = validEnd;
+            return false;
+        }
+
+        // Appends the account and block tables, fills in the header and
+        // moves the file to SEGMENT_DIR, then starts a new live segment.
+        // Called with rotation held exclusively.
+        void sealLog() {
+            std::vector<TransactionSegment::AccountEntry> table;
+            std::vector<uint64_t> locations;
+            index.accountTable(table, locations);
+            TransactionSegment::SegmentHeader header = TransactionSegment::sealedHeader(segmentId, liveStats, logSize, table);
+            const uint64_t blockCount = liveBlocks.size();
+            out.write(reinterpret_cast<const char*>(table.data()),
+                      static_cast<std::streamsize>(table.size() * sizeof(TransactionSegment::AccountEntry)));
+            out.write(reinterpret_cast<const char*>(locations.data()),
+                      static_cast<std::streamsize>(locations.size() * sizeof(uint64_t)));
+            out.write(reinterpret_cast<const char*>(liveBlocks.data()),
+                      static_cast<std::streamsize>(blockCount * sizeof(uint64_t)));
+            out.write(reinterpret_cast<const char*>(&blockCount), sizeof(blockCount));
+            out.flush();
+            bool written = out.good();
+            out.close();
+            if (!written || !writeHeader(header) || !moveSealed(header)) {
+                unseal(header);
+                out.open(LOG_FILE, std::ios::app | std::ios::binary);
+                return;
+            }
+            index.reset();
+            createLog();
+            index.ensureLoaded();
+        }
+
+        bool rotationDue(const Options& current) const {
+            if (liveStats.empty()) return false;
+            if (current.maxSegmentBytes > 0 && logSize + block.bytes() > current.maxSegmentBytes) return true;
+            return current.rotateDaily && liveStats.timed() && blockStats.timed() &&
+                   TimeFormat::day(blockStats.maxTimestampMs) > TimeFormat::day(liveStats.maxTimestampMs);
+        }
+
+        void append(const QueuedRecord& record) {
+            TransactionSegment::Row row;
+            TransactionSegment::fromText(record.transactionID, record.accountNumber, record.type,
+                                         static_cast<int64_t>(std::llround(record.amount * 100.0)),
+                                         record.timestampText, row);
+            if (record.transactionID[0] == '\0') row.id = record.id;
+            if (record.timestampText[0] == '\0') row.timestampMs = record.timestampMs;
+            if (row.type == TransactionSegment::TYPE_TRANSFER) {
+                TransactionSegment::parseAccount(record.counterparty, row.counterparty, row.counterpartyDigits,
+                                                 row.counterpartyText);
+            }
+            TransactionLogIndex::entries(0, static_cast<uint32_t>(block.size()), row, blockEntries);
+            block.add(row);
+            blockStats.add(row);
+            popped++;
+        }
+
+        void writeOut(const Options& current) {
+            lastWrite = std::chrono::steady_clock::now();
+            if (!block.empty()) {
+                if (out.is_open() && rotationDue(current)) {
+                    std::unique_lock<std::shared_mutex> guard(rotation);
+                    sealLog();
+                }
+                encoded.clear();
+                block.finish(encoded);
+                if (out.is_open()) {
+                    out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+                    out.flush();
+                    for (TransactionLogIndex::Entry& entry : blockEntries) entry.block = logSize;
+                    {
+                        std::lock_guard<std::mutex> guard(blocksLock);
+                        liveBlocks.push_back(logSize);
+                        liveRecords += blockStats.recordCount;
+                    }
+                    logSize += encoded.size();
+                    index.add(blockEntries, logSize);
+                    liveStats.merge(blockStats);
+                }
+                blockEntries.clear();
+                blockStats = TransactionSegment::SegmentStats();
+            }
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                durable = popped;
+            }
+            drained.notify_all();
+        }
+
+        bool intervalElapsed(const Options& current) const {
+            return std::chrono::steady_clock::now() - lastWrite >= std::chrono::milliseconds(current.flushIntervalMs);
+        }
+
+        bool due(const Options& current) const {
+            if (block.bytes() >= current.maxBufferBytes || block.size() >= TransactionSegment::MAX_BLOCK_RECORDS) return true;
+            switch (current.policy) {
+            case FlushPolicy::EveryRecord:
+                return true;
+            case FlushPolicy::EveryNRecords:
+                return block.size() >= current.flushEveryRecords;
+            case FlushPolicy::Interval:
+                return intervalElapsed(current);
+            }
+            return true;
+        }
+
+        void run() {
+            // Catch the index up with the log (or rebuild it) before the
+            // first history lookup needs it.
+            index.ensureLoaded();
+            std::unique_lock<std::mutex> guard(lock);
+            for (;;) {
+                const Options current = options;
+                const bool flushWanted = flushWaiters > 0;
+                const bool stop = stopping;
+                guard.unlock();
+
+                QueuedRecord record;
+                while (queue.tryPop(record)) {
+                    append(record);
+                    if (due(current)) writeOut(current);
+                }
+                if (!block.empty() && (flushWanted || stop || intervalElapsed(current))) writeOut(current);
+
+                guard.lock();
+                if (queue.size() > 0) {
+                    // A producer has claimed a slot but not filled it yet.
+                    if (stop || flushWaiters > 0) {
+                        guard.unlock();
+                        std::this_thread::yield();
+                        guard.lock();
+                    }
+                    continue;
+                }
+                if (stop) return;
+                if (flushWaiters > 0 && !block.empty()) continue;
+                idle.store(true);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (queue.size() == 0 && !stopping) {
+                    auto timeout = block.empty() ? std::chrono::milliseconds(1000)
+                                                  : std::chrono::milliseconds(current.flushIntervalMs);
+                    wake.wait_for(guard, timeout);
+                }
+                idle.store(false);
+            }
+        }
+    };
+
+    static Writer& writer() {
+        static Writer instance;
+        return instance;
+    }
+
+    template <size_t N>
+    static void copyField(char (&field)[N], std::string_view value) {
+        size_t n = std::min(value.size(), N - 1);
+        if (n > 0) std::memcpy(field, value.data(), n);
+        field[n] = '\0';
+    }
+
+    // With an account number, a transfer becomes that account's leg.
+    static TransactionRecord toRecord(const TransactionSegment::Row& row, const std::string& accountNumber = "") {
+        TransactionRecord rec;
+        if (row.idText.empty()) rec.id = row.id;
+        if (row.accountText.empty()) {
+            rec.account = row.card;
+            rec.accountDigits = row.cardDigits;
+        }
+        rec.type = row.type;
+        if (row.type == TransactionSegment::TYPE_TRANSFER && row.counterpartyText.empty()) {
+            rec.counterparty = row.counterparty;
+            rec.counterpartyDigits = row.counterpartyDigits;
+        }
+        if (row.type == TransactionSegment::TYPE_TRANSFER && !accountNumber.empty()) {
+            rec.type = TransactionSegment::TYPE_TRANSFER_OUT;
+            if (row.accountNumber() != accountNumber) {
+                rec.type = TransactionSegment::TYPE_TRANSFER_IN;
+                std::swap(rec.account, rec.counterparty);
+                std::swap(rec.accountDigits, rec.counterpartyDigits);
+            }
+        }
+        rec.amountCents = row.amountCents;
+        if (row.timestampText.empty()) rec.timestampMs = row.timestampMs;
+        return rec;
+    }
+
+    // Whether a row belongs in a read limited to [fromMs, toMs]. Records
+    // whose timestamp could not be parsed only appear in unlimited reads.
+    static bool inRange(const TransactionSegment::Row& row, int64_t fromMs, int64_t toMs) {
+        if (fromMs == INT64_MIN && toMs == INT64_MAX) return true;
+        return row.timestampText.empty() && row.timestampMs >= fromMs && row.timestampMs <= toMs;
+    }
+
+    // Calls fn(file, header, live) for each segment that may hold records
+    // in [fromMs, toMs], oldest first, ending with the live segment.
+    template <typename Fn>
+    static void forEachSegment(int64_t fromMs, int64_t toMs, Fn&& fn) {
+        Writer& w = writer();
+        const bool unlimited = fromMs == INT64_MIN && toMs == INT64_MAX;
+        std::shared_lock<std::shared_mutex> guard(w.rotation);
+        TransactionSegment::SegmentHeader header;
+        for (const SealedSegment& segment : w.segments) {
+            if (!unlimited && !TransactionSegment::overlaps(segment.header, fromMs, toMs)) continue;
+            MappedFile file;
+            if (file.open(segment.path, false) && TransactionSegment::readHeader(file.data(), file.size(), header)) {
+                fn(file, header, false);
+            }
+        }
+        MappedFile live;
+        if (live.open(LOG_FILE, false) && TransactionSegment::readHeader(live.data(), live.size(), header)) {
+            fn(live, header, true);
+        }
+    }
 
 public:
-    static void logTransaction(const std::shared_ptr<Transaction>& trans, const std::string& type) {
-        std::ofstream file(LOG_FILE, std::ios::app);
-        if (file.is_open()) {
-            file << trans->getTransactionID() << ","
-                 << trans->getAccountNumber() << ","
-                 << type << ","
-                 << std::fixed << std::setprecision(2) << trans->getAmount() << ","
-                 << trans->getTimestamp() << "\n";
-            file.close();
+    static void configure(const Options& options) {
+        Writer& w = writer();
+        {
+            std::lock_guard<std::mutex> guard(w.lock);
+            w.options = options;
         }
+        w.wake.notify_one();
+    }
+
+    // Only copies the record into the queue; the background writer does the
+    // encoding and file I/O.
+    static void logTransaction(const Transaction& trans) {
+        QueuedRecord record;
+        record.id = trans.getID();
+        record.transactionID[0] = '\0';
+        copyField(record.accountNumber, trans.getAccountNumber());
+        copyField(record.type, trans.getType());
+        copyField(record.counterparty, trans.getCounterparty());
+        record.timestampMs = trans.getTimestampMs();
+        record.timestampText[0] = '\0';
+        record.amount = trans.getAmount();
+        writer().enqueue(record);
+    }
+
+    // Blocks until every record logged before the call is in the file
+    // (shutdown, before reading the log).
+    static void flush() {
+        Writer& w = writer();
+        const uint64_t target = w.queue.pushCount();
+        std::unique_lock<std::mutex> guard(w.lock);
+        if (w.durable >= target) return;
+        w.flushWaiters++;
+        w.wake.notify_one();
+        w.drained.wait(guard, [&w, target] { return w.durable >= target; });
+        w.flushWaiters--;
     }
 
-    static std::vector<TransactionRecord> readTransactions(const std::string& accountNumber = "") {
+    static Stats getStats() {
+        Writer& w = writer();
+        Stats stats;
+        stats.enqueued = w.queue.pushCount();
+        stats.backpressureWaits = w.backpressureWaits.load();
+        stats.queueDepth = w.queue.size();
+        stats.maxQueueDepth = w.maxQueueDepth.load();
+        stats.queueCapacity = w.queue.capacity();
+        std::lock_guard<std::mutex> guard(w.lock);
+        stats.written = w.durable;
+        return stats;
+    }
+
+    // Calls fn(row) for every record in the log with a timestamp in [fromMs,
+    // toMs], oldest first; see TransactionSegment::Row. Records logged before
+    // the call are included. Sealed segments outside the range are skipped
+    // without being opened.
+    template <typename Fn>
+    static void forEachRow(Fn&& fn, int64_t fromMs = INT64_MIN, int64_t toMs = INT64_MAX) {
+        flush();
+        std::vector<TransactionSegment::Row> rows;
+        forEachSegment(fromMs, toMs, [&](const MappedFile& file, const TransactionSegment::SegmentHeader& header, bool) {
+            size_t end = TransactionSegment::blocksEnd(header, file.size());
+            TransactionSegment::forEachBlock(file.data(), end, 0, [&](uint64_t, const char* block, size_t bytes) {
+                if (!TransactionSegment::decode(block, bytes, rows)) return;
+                for (const TransactionSegment::Row& row : rows) {
+                    if (inRange(row, fromMs, toMs)) fn(row);
+                }
+            });
+        });
+    }
+
+    // With an account number, only the blocks holding that account's
+    // records are decoded: found through the index in the live segment and
+    // through the account table in sealed ones, which are skipped if the
+    // account has no records there.
+    static std::vector<TransactionRecord> readTransactions(const std::string& accountNumber = "",
+                                                           int64_t fromMs = INT64_MIN, int64_t toMs = INT64_MAX) {
         std::vector<TransactionRecord> records;
-        std::ifstream file(LOG_FILE);
-        if (file.is_open()) {
-            std::string line;
-            while (std::getline(file, line)) {
-                if (line.empty()) continue;
-                
-                std::stringstream ss(line);
-                std::string id, account, type, amount, timestamp;
-                
-                if (std::getline(ss, id, ',') &&
-                    std::getline(ss, account, ',') &&
-                    std::getline(ss, type, ',') &&
-                    std::getline(ss, amount, ',') &&
-                    std::getline(ss, timestamp, ',')) {
-                    
-                    if (accountNumber.empty() || account == accountNumber) {
-                        TransactionRecord rec;
-                        rec.transactionID = id;
-                        rec.accountNumber = account;
-                        rec.type = type;
-                        rec.amount = std::stod(amount);
-                        rec.timestamp = timestamp;
-                        records.push_back(rec);
+        uint32_t card = 0;
+        if (!accountNumber.empty() && TransactionLogIndex::parseCard(accountNumber, card)) {
+            flush();
+            Writer& w = writer();
+            std::vector<TransactionSegment::Row> rows;
+            forEachSegment(fromMs, toMs, [&](const MappedFile& file, const TransactionSegment::SegmentHeader& header, bool live) {
+                std::vector<uint64_t> locations = live ? w.index.locationsFor(card)
+                                                       : TransactionSegment::locationsFor(file.data(), file.size(), header, card);
+                size_t end = TransactionSegment::blocksEnd(header, file.size());
+                uint64_t decoded = UINT64_MAX;
+                for (uint64_t location : locations) {
+                    uint64_t block = TransactionSegment::blockOf(location);
+                    if (block != decoded) {
+                        rows.clear();
+                        if (block < end) TransactionSegment::decode(file.data() + block, end - static_cast<size_t>(block), rows);
+                        decoded = block;
+                    }
+                    uint32_t row = TransactionSegment::rowOf(location);
+                    if (row < rows.size() && rows[row].involves(accountNumber) && inRange(rows[row], fromMs, toMs)) {
+                        records.push_back(toRecord(rows[row], accountNumber));
                     }
                 }
-            }
-            file.close();
+            });
+            return records;
         }
+        forEachRow([&](const TransactionSegment::Row& row) {
+            if (accountNumber.empty() || row.involves(accountNumber)) records.push_back(toRecord(row, accountNumber));
+        }, fromMs, toMs);
         return records;
     }
+
+    // Pages through the log newest first: every record, or one account's.
+    // Each segment is read from its tail (the live segment's block list, a
+    // sealed segment's block table or account table), so a page costs the
+    // decoding of the few blocks that hold it however long the log is. Any
+    // page can be reached directly: whole segments are skipped by their
+    // record counts and blocks by the counts in their headers, without
+    // decoding. The cursor keeps the page shown and the one after it, so
+    // its memory does not grow with the log or with the pages visited. It
+    // sees the log as it was when opened and holds no file or lock between
+    // calls.
+    class Cursor {
+    private:
+        struct Segment {
+            uint64_t id;
+            bool live;
+            uint64_t items;   // blocks, or the account's records; UINT64_MAX until first read
+            uint64_t records; // UINT64_MAX until first counted
+        };
+
+        // A point in the log: items of segment already passed, newest first,
+        // and rows of the next block already passed (all records only).
+        struct Position {
+            size_t segment{0};
+            uint64_t taken{0};
+            uint32_t rowsTaken{0};
+        };
+
+        std::string accountNumber;
+        uint32_t card{0};
+        bool byCard{false};
+        size_t pageSize{4};
+        std::vector<Segment> segments; // newest first
+        uint64_t totalRecords{UINT64_MAX};
+        size_t shownPage{0};
+        bool loaded{false};
+        std::vector<TransactionRecord> shown;
+        std::vector<TransactionRecord> following;
+        Position next; // where the page after following starts
+        // Block offsets or locations of the segment being read, when they
+        // are not read from the file directly.
+        size_t cachedSegment{SIZE_MAX};
+        std::vector<uint64_t> cachedItems;
+
+        // Records can be counted without reading them, unless the account
+        // number is not indexed and every record has to be compared.
+        bool countable() const { return accountNumber.empty() || byCard; }
+
+        // Maps the segment, following it to SEGMENT_DIR if it was the live
+        // one and has been sealed since. Called with rotation held.
+        static bool openSegment(const Segment& segment, MappedFile& file, TransactionSegment::SegmentHeader& header,
+                                bool& live) {
+            Writer& w = writer();
+            live = false;
+            if (segment.live && file.open(LOG_FILE, false) &&
+                TransactionSegment::readHeader(file.data(), file.size(), header) && header.segmentId == segment.id) {
+                live = true;
+                return true;
+            }
+            for (const SealedSegment& sealed : w.segments) {
+                if (sealed.header.segmentId != segment.id) continue;
+                return file.open(sealed.path, false) && TransactionSegment::readHeader(file.data(), file.size(), header);
+            }
+            return false;
+        }
+
+        // Blocks or account locations of a segment, oldest first, when they
+        // have to be copied: the account's locations, or the blocks of a
+        // segment sealed without a block table.
+        void cacheItems(size_t ordinal, const MappedFile& file, const TransactionSegment::SegmentHeader& header,
+                        bool live) {
+            if (cachedSegment == ordinal) return;
+            cachedSegment = ordinal;
+            cachedItems.clear();
+            if (byCard) {
+                cachedItems = live ? writer().index.locationsFor(card)
+                                   : TransactionSegment::locationsFor(file.data(), file.size(), header, card);
+            } else {
+                TransactionSegment::forEachBlock(file.data(), TransactionSegment::blocksEnd(header, file.size()), 0,
+                    [this](uint64_t offset, const char*, size_t) { cachedItems.push_back(offset); });
+            }
+        }
+
+        // An open segment and how to find its items from the tail.
+        struct Source {
+            MappedFile file;
+            TransactionSegment::SegmentHeader header;
+            bool live{false};
+            size_t end{0};
+            const char* table{nullptr};
+        };
+
+        // Opens segment ordinal for reading and fills in its item count.
+        // Called with rotation held.
+        bool open(size_t ordinal, Source& source) {
+            Segment& segment = segments[ordinal];
+            if (!openSegment(segment, source.file, source.header, source.live)) return false;
+            source.end = TransactionSegment::blocksEnd(source.header, source.file.size());
+            uint64_t tableCount = 0;
+            source.table = nullptr;
+            if (!byCard && !TransactionSegment::blockTable(source.file.data(), source.file.size(), source.header,
+                                                          source.table, tableCount)) {
+                source.table = nullptr;
+            }
+            if (byCard || (!source.table && !source.live)) cacheItems(ordinal, source.file, source.header, source.live);
+            if (segment.items == UINT64_MAX) segment.items = source.table ? tableCount : cachedItems.size();
+            return true;
+        }
+
+        // Block offset of item (counted from the oldest) of an open segment;
+        // for account cursors, the record's location.
+        uint64_t itemAt(const Source& source, uint64_t item) {
+            if (byCard) return cachedItems[item];
+            if (source.table) return TransactionSegment::blockOffset(source.table, item);
+            if (source.live) {
+                Writer& w = writer();
+                std::lock_guard<std::mutex> blocksGuard(w.blocksLock);
+                return w.liveBlocks[item];
+            }
+            return cachedItems[item];
+        }
+
+        // Records of segment ordinal this cursor sees, counted without
+        // reading them. Called with rotation held.
+        uint64_t recordsIn(size_t ordinal) {
+            Segment& segment = segments[ordinal];
+            if (segment.records != UINT64_MAX) return segment.records;
+            segment.records = 0;
+            if (byCard) {
+                Source source;
+                if (open(ordinal, source)) segment.records = segment.items;
+            } else {
+                for (const SealedSegment& sealed : writer().segments) {
+                    if (sealed.header.segmentId == segment.id) segment.records = sealed.header.recordCount;
+                }
+            }
+            return segment.records;
+        }
+
+        // Appends up to count records older than at to out, newest first,
+        // and moves at past them.
+        void read(Position& at, size_t count, std::vector<TransactionRecord>& out) {
+            std::shared_lock<std::shared_mutex> guard(writer().rotation);
+            std::vector<TransactionSegment::Row> rows;
+            while (out.size() < count && at.segment < segments.size()) {
+                Source source;
+                if (!open(at.segment, source)) {
+                    // Archived since the cursor was opened.
+                    at = Position{at.segment + 1, 0, 0};
+                    continue;
+                }
+                const uint64_t items = segments[at.segment].items;
+                uint64_t decoded = UINT64_MAX;
+                while (out.size() < count && at.taken < items) {
+                    const uint64_t item = itemAt(source, items - 1 - at.taken);
+                    const uint64_t block = byCard ? TransactionSegment::blockOf(item) : item;
+                    if (block != decoded) {
+                        rows.clear();
+                        if (block < source.end) {
+                            TransactionSegment::decode(source.file.data() + block, source.end - static_cast<size_t>(block), rows);
+                        }
+                        decoded = block;
+                    }
+                    if (byCard) {
+                        const uint32_t row = TransactionSegment::rowOf(item);
+                        if (row < rows.size() && rows[row].involves(accountNumber)) {
+                            out.push_back(toRecord(rows[row], accountNumber));
+                        }
+                        at.taken++;
+                        continue;
+                    }
+                    while (out.size() < count && at.rowsTaken < rows.size()) {
+                        const TransactionSegment::Row& row = rows[rows.size() - 1 - at.rowsTaken];
+                        at.rowsTaken++;
+                        if (accountNumber.empty() || row.involves(accountNumber)) out.push_back(toRecord(row, accountNumber));
+                    }
+                    if (at.rowsTaken >= rows.size()) {
+                        at.taken++;
+                        at.rowsTaken = 0;
+                    }
+                }
+                if (at.taken >= items) at = Position{at.segment + 1, 0, 0};
+            }
+        }
+
+        // The point skip records from the newest; skipped is how many were
+        // passed, fewer than skip if the log ends first.
+        Position seek(uint64_t skip, uint64_t& skipped) {
+            Position at;
+            if (!countable()) {
+                // Every record has to be compared; pass them a page's worth
+                // at a time.
+                std::vector<TransactionRecord> passed;
+                skipped = 0;
+                while (skipped < skip) {
+                    passed.clear();
+                    read(at, static_cast<size_t>(std::min<uint64_t>(skip - skipped, 256)), passed);
+                    if (passed.empty()) break;
+                    skipped += passed.size();
+                }
+                return at;
+            }
+            std::shared_lock<std::shared_mutex> guard(writer().rotation);
+            uint64_t remaining = skip;
+            for (; at.segment < segments.size(); at.segment++) {
+                const uint64_t records = recordsIn(at.segment);
+                if (remaining >= records) {
+                    remaining -= records;
+                    continue;
+                }
+                Source source;
+                if (!open(at.segment, source)) continue;
+                if (byCard) {
+                    at.taken = remaining;
+                    remaining = 0;
+                    break;
+                }
+                const uint64_t items = segments[at.segment].items;
+                for (; at.taken < items; at.taken++) {
+                    const uint64_t block = itemAt(source, items - 1 - at.taken);
+                    const uint32_t blockRecords = block < source.end
+                        ? TransactionSegment::blockRecords(source.file.data() + block, source.end - static_cast<size_t>(block))
+                        : 0;
+                    if (remaining < blockRecords) {
+                        at.rowsTaken = static_cast<uint32_t>(remaining);
+                        remaining = 0;
+                        break;
+                    }
+                    remaining -= blockRecords;
+                }
+                if (at.taken < items) break;
+                at.taken = 0;
+            }
+            skipped = skip - remaining;
+            return at;
+        }
+
+    public:
+        Cursor() = default;
+
+        Cursor(const std::string& account, size_t recordsPerPage) : accountNumber(account), pageSize(recordsPerPage) {
+            if (pageSize == 0) pageSize = 1;
+            byCard = !accountNumber.empty() && TransactionLogIndex::parseCard(accountNumber, card);
+            flush();
+            Writer& w = writer();
+            std::shared_lock<std::shared_mutex> guard(w.rotation);
+            MappedFile live;
+            TransactionSegment::SegmentHeader header;
+            if (live.open(LOG_FILE, false) && TransactionSegment::readHeader(live.data(), live.size(), header)) {
+                uint64_t items = 0;
+                uint64_t records = 0;
+                if (byCard) {
+                    items = records = w.index.countFor(card);
+                } else {
+                    std::lock_guard<std::mutex> blocksGuard(w.blocksLock);
+                    items = w.liveBlocks.size();
+                    records = w.liveRecords;
+                }
+                segments.push_back(Segment{header.segmentId, true, items, records});
+            }
+            for (auto it = w.segments.rbegin(); it != w.segments.rend(); ++it) {
+                segments.push_back(Segment{it->header.segmentId, false, UINT64_MAX, UINT64_MAX});
+            }
+        }
+
+        size_t recordsPerPage() const { return pageSize; }
+
+        // The page last returned by page().
+        size_t pageIndex() const { return shownPage; }
+
+        // Number of records the cursor pages through. Only counted from
+        // segment and account tables; reading every record is needed only
+        // for an account number that is not indexed. Account numbers that
+        // differ only in leading zeros share one count.
+        uint64_t records() {
+            if (totalRecords != UINT64_MAX) return totalRecords;
+            if (countable()) {
+                std::shared_lock<std::shared_mutex> guard(writer().rotation);
+                uint64_t total = 0;
+                for (size_t i = 0; i < segments.size(); ++i) total += recordsIn(i);
+                totalRecords = total;
+            } else {
+                uint64_t total = 0;
+                seek(UINT64_MAX, total);
+                totalRecords = total;
+            }
+            return totalRecords;
+        }
+
+        size_t pageCount() { return static_cast<size_t>((records() + pageSize - 1) / pageSize); }
+
+        // Records of page index (0 = newest), newest first; the page after it
+        // is read ahead. Past the last page, the last page.
+        const std::vector<TransactionRecord>& page(size_t index) {
+            if (loaded && index == shownPage) return shown;
+            if (loaded && index > shownPage && following.empty()) return shown;
+            if (loaded && index == shownPage + 1) {
+                shown.swap(following);
+                shownPage = index;
+            } else {
+                uint64_t skipped = 0;
+                Position at = seek(static_cast<uint64_t>(index) * pageSize, skipped);
+                shown.clear();
+                read(at, pageSize, shown);
+                if (shown.empty() && skipped > 0) {
+                    index = static_cast<size_t>((skipped - 1) / pageSize);
+                    at = seek(static_cast<uint64_t>(index) * pageSize, skipped);
+                    read(at, pageSize, shown);
+                }
+                shownPage = index;
+                loaded = true;
+                next = at;
+            }
+            following.clear();
+            read(next, pageSize, following);
+            return shown;
+        }
+
+        // Whether page index has records; known for pages up to the one
+        // after the page shown.
+        bool hasPage(size_t index) {
+            page(loaded ? shownPage : 0);
+            if (index < shownPage) return true;
+            if (index == shownPage) return !shown.empty();
+            return index == shownPage + 1 && !following.empty();
+        }
+    };
+
+    // A cursor over the whole log, or one account's records.
+    static Cursor newestFirst(const std::string& accountNumber = "", size_t recordsPerPage = 4) {
+        return Cursor(accountNumber, recordsPerPage);
+    }
+
+    // Moves sealed segments whose newest record is older than beforeMs to
+    // ARCHIVE_DIR, where readers no longer see them. The live segment is
+    // never touched. Returns the number of segments moved.
+    static size_t archiveSegments(int64_t beforeMs) {
+        Writer& w = writer();
+        std::unique_lock<std::shared_mutex> guard(w.rotation);
+        std::error_code error;
+        std::filesystem::create_directories(ARCHIVE_DIR, error);
+        std::vector<SealedSegment> kept;
+        size_t moved = 0;
+        for (const SealedSegment& segment : w.segments) {
+            const TransactionSegment::SegmentHeader& header = segment.header;
+            if (header.minTimestampMs <= header.maxTimestampMs && header.maxTimestampMs < beforeMs) {
+                std::filesystem::path target = std::filesystem::path(ARCHIVE_DIR) / std::filesystem::path(segment.path).filename();
+                std::filesystem::rename(segment.path, target, error);
+                if (!error) {
+                    moved++;
+                    continue;
+                }
+            }
+            kept.push_back(segment);
+        }
+        w.segments.swap(kept);
+        return moved;
+    }
+
+    // Appends the records of a CSV log to the log.
+    static bool importCsv(const std::string& path, size_t& imported) {
+        imported = 0;
+        bool ok = writer().importFile(path, imported);
+        flush();
+        return ok;
+    }
+
+    // Writes the whole log as CSV, one id,account,type,amount,timestamp line
+    // per record; a TRANSFER line ends with its recipient.
+    static bool exportCsv(const std::string& path, size_t& exported) {
+        exported = 0;
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        std::string buffer;
+        forEachRow([&](const TransactionSegment::Row& row) {
+            TransactionSegment::appendCsvLine(buffer, row);
+            exported++;
+            if (buffer.size() >= 64 * 1024) {
+                file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        });
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        return file.good();
+    }
 };
 
 #endif // TRANSACTIONLOG_H
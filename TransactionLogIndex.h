@@ -0,0 +1,227 @@
+#ifndef TRANSACTIONLOGINDEX_H
+#define TRANSACTIONLOGINDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <cstdint>
+#include <cstring>
+#include "CardMap.h"
+#include "MappedFile.h"
+#include "TransactionSegment.h"
+
+// Sidecar index for the live transaction log segment (transaction_log.idx):
+// one 16-byte entry per record and account (a transfer has one for its
+// sender and one for its recipient) holding the record's block byte offset,
+// its row in the block and the account, so one account's history costs a
+// decode of the blocks holding its own records instead of a pass over the
+// whole segment.
+// Entries are appended right after the blocks they describe. On load, blocks
+// the index missed (a crash between the two writes) are indexed from the log,
+// and an index that belongs to another segment or whose last entry does not
+// match the log is rebuilt from scratch. When the segment is sealed, the
+// index becomes its account table (see TransactionSegment.h).
+class TransactionLogIndex {
+public:
+    struct Entry {
+        uint64_t block;
+        uint32_t card;
+        uint32_t row;
+    };
+    static_assert(sizeof(Entry) == 16, "Entry layout is part of the file format");
+
+private:
+    static constexpr char MAGIC[8] = {'T', 'X', 'L', 'O', 'G', 'I', 'X', '3'};
+    // MAGIC, then the segmentId of the log segment indexed.
+    static constexpr size_t HEADER_BYTES = sizeof(MAGIC) + sizeof(uint64_t);
+
+    std::string logPath;
+    std::string indexPath;
+    std::mutex lock;
+    bool loaded{false};
+    // Per account, TransactionSegment::location of each record, in log order.
+    CardMap<std::vector<uint64_t>> locations;
+    // Log bytes the index accounts for; later entries start at or past it.
+    uint64_t coveredEnd{0};
+    std::ofstream out;
+
+    static bool indexed(const TransactionSegment::Row& row) {
+        return row.accountText.empty() && row.cardDigits > 0;
+    }
+
+    static bool indexedCounterparty(const TransactionSegment::Row& row) {
+        return row.type == TransactionSegment::TYPE_TRANSFER && row.counterpartyText.empty() &&
+               row.counterpartyDigits > 0 && row.counterparty != row.card;
+    }
+
+    void addLocked(const Entry& entry) {
+        locations[entry.card].push_back(TransactionSegment::location(entry.block, entry.row));
+    }
+
+    void loadLocked() {
+        loaded = true;
+        locations.clear();
+        coveredEnd = 0;
+
+        MappedFile log;
+        size_t logSize = 0;
+        TransactionSegment::SegmentHeader header{};
+        if (log.open(logPath, false) && TransactionSegment::readHeader(log.data(), log.size(), header)) {
+            logSize = TransactionSegment::blocksEnd(header, log.size());
+        }
+        std::vector<TransactionSegment::Row> rows;
+
+        std::vector<Entry> existing;
+        bool valid = false;
+        {
+            std::ifstream file(indexPath, std::ios::binary | std::ios::ate);
+            std::streamoff size = file.is_open() ? static_cast<std::streamoff>(file.tellg()) : 0;
+            const std::streamoff headerBytes = static_cast<std::streamoff>(HEADER_BYTES);
+            char magic[sizeof(MAGIC)] = {};
+            uint64_t segmentId = 0;
+            if (logSize > 0 && size >= headerBytes && (size - headerBytes) % sizeof(Entry) == 0) {
+                file.seekg(0);
+                file.read(magic, sizeof(magic));
+                file.read(reinterpret_cast<char*>(&segmentId), sizeof(segmentId));
+                existing.resize(static_cast<size_t>(size - headerBytes) / sizeof(Entry));
+                file.read(reinterpret_cast<char*>(existing.data()),
+                          static_cast<std::streamsize>(existing.size() * sizeof(Entry)));
+                valid = file.good() && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                        segmentId == header.segmentId;
+            }
+        }
+        if (valid && !existing.empty()) {
+            const Entry& last = existing.back();
+            valid = false;
+            if (last.block < logSize) {
+                const char* block = log.data() + last.block;
+                size_t available = logSize - static_cast<size_t>(last.block);
+                if (TransactionSegment::decode(block, available, rows) && last.row < rows.size() &&
+                    ((indexed(rows[last.row]) && rows[last.row].card == last.card) ||
+                     (indexedCounterparty(rows[last.row]) && rows[last.row].counterparty == last.card))) {
+                    coveredEnd = last.block + TransactionSegment::blockBytes(block, available, false);
+                    valid = true;
+                }
+            }
+        }
+        if (!valid) existing.clear();
+        for (const Entry& entry : existing) addLocked(entry);
+
+        std::vector<Entry> missing;
+        if (logSize > 0) {
+            coveredEnd = TransactionSegment::forEachBlock(log.data(), logSize, static_cast<size_t>(coveredEnd),
+                [&](uint64_t offset, const char* block, size_t bytes) {
+                    if (!TransactionSegment::decode(block, bytes, rows)) return;
+                    for (size_t i = 0; i < rows.size(); ++i) entries(offset, static_cast<uint32_t>(i), rows[i], missing);
+                });
+        }
+
+        if (valid) {
+            out.open(indexPath, std::ios::app | std::ios::binary);
+        } else {
+            out.open(indexPath, std::ios::trunc | std::ios::binary);
+            out.write(MAGIC, sizeof(MAGIC));
+            out.write(reinterpret_cast<const char*>(&header.segmentId), sizeof(header.segmentId));
+        }
+        out.write(reinterpret_cast<const char*>(missing.data()), static_cast<std::streamsize>(missing.size() * sizeof(Entry)));
+        out.flush();
+        for (const Entry& entry : missing) addLocked(entry);
+    }
+
+public:
+    TransactionLogIndex(const std::string& log, const std::string& index) : logPath(log), indexPath(index) {}
+
+    // Account numbers are indexed by their integer value; others are not
+    // indexed at all.
+    static bool parseCard(std::string_view text, uint32_t& card) {
+        if (text.empty() || text.size() > 9) return false;
+        uint32_t value = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') return false;
+            value = value * 10 + static_cast<uint32_t>(c - '0');
+        }
+        card = value;
+        return true;
+    }
+
+    // Appends the entries of the record at row of block.
+    static void entries(uint64_t block, uint32_t row, const TransactionSegment::Row& record, std::vector<Entry>& out) {
+        if (indexed(record)) out.push_back(Entry{block, record.card, row});
+        if (indexedCounterparty(record)) out.push_back(Entry{block, record.counterparty, row});
+    }
+
+    // Reads (or rebuilds) the index the first time it is needed.
+    void ensureLoaded() {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!loaded) loadLocked();
+    }
+
+    // Records blocks that were just written, in log order; end is the log
+    // size after them. Blocks already picked up by a load are skipped.
+    void add(const std::vector<Entry>& entries, uint64_t end) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!loaded) loadLocked();
+        size_t first = 0;
+        while (first < entries.size() && entries[first].block < coveredEnd) ++first;
+        if (first < entries.size()) {
+            out.write(reinterpret_cast<const char*>(entries.data() + first),
+                      static_cast<std::streamsize>((entries.size() - first) * sizeof(Entry)));
+            out.flush();
+            for (size_t i = first; i < entries.size(); ++i) addLocked(entries[i]);
+        }
+        if (end > coveredEnd) coveredEnd = end;
+    }
+
+    // Forgets the index; the next use reloads it against the log file, which
+    // has been replaced.
+    void reset() {
+        std::lock_guard<std::mutex> guard(lock);
+        loaded = false;
+        locations.clear();
+        coveredEnd = 0;
+        out.close();
+    }
+
+    // TransactionSegment::location of each of the account's records, oldest
+    // first.
+    std::vector<uint64_t> locationsFor(uint32_t card) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!loaded) loadLocked();
+        const std::vector<uint64_t>* found = locations.find(card);
+        return found ? *found : std::vector<uint64_t>();
+    }
+
+    // Number of the account's records.
+    size_t countFor(uint32_t card) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!loaded) loadLocked();
+        const std::vector<uint64_t>* found = locations.find(card);
+        return found ? found->size() : 0;
+    }
+
+    // The account table for sealing the segment: entries sorted by card,
+    // indexing into locationsOut.
+    void accountTable(std::vector<TransactionSegment::AccountEntry>& table, std::vector<uint64_t>& locationsOut) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!loaded) loadLocked();
+        table.clear();
+        locationsOut.clear();
+        locations.forEach([&table](uint32_t card, const std::vector<uint64_t>& cardLocations) {
+            table.push_back(TransactionSegment::AccountEntry{card, static_cast<uint32_t>(cardLocations.size()), 0});
+        });
+        std::sort(table.begin(), table.end(),
+                  [](const TransactionSegment::AccountEntry& a, const TransactionSegment::AccountEntry& b) {
+                      return a.card < b.card;
+                  });
+        for (TransactionSegment::AccountEntry& entry : table) {
+            const std::vector<uint64_t>* cardLocations = locations.find(entry.card);
+            entry.firstLocation = locationsOut.size();
+            locationsOut.insert(locationsOut.end(), cardLocations->begin(), cardLocations->end());
+        }
+    }
+};
+
+#endif // TRANSACTIONLOGINDEX_H
@@ -0,0 +1,626 @@
+#ifndef TRANSACTIONSEGMENT_H
+#define TRANSACTIONSEGMENT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include "AccountRow.h"
+#include "TimeFormat.h"
+
+// Binary columnar format of the transaction log. A segment file (the live
+// transaction_log.bin or a sealed segment) is an 8-byte magic, a
+// SegmentHeader and then blocks; each block holds the records of one writer
+// flush, stored column by column:
+//   flags       1 byte per record: type code plus which fields are text
+//   ids         "TXN<n>" ids as zigzag varint deltas of n
+//   accounts    all-digit account numbers as varint(number * 16 + digits);
+//               a transfer's recipient follows its sender
+//   amounts     cents as zigzag varints
+//   timestamps  epoch milliseconds as zigzag varint deltas from the block's
+//               base timestamp
+//   text        any field that does not fit the above, as length + bytes
+// Every column's size is in the block header, so a scan can reach any column
+// without decoding the ones before it. Blocks carry a checksum so a block
+// torn by a crash mid-write is recognised and dropped.
+//
+// Sealing a segment appends an account table (AccountEntry per account,
+// sorted by card), the locations of each account's records and a block
+// table (the offset of every block, then their count, at the very end of
+// the file), then fills in the header: the min/max timestamp and the
+// account table's position. Readers use the header to skip segments outside
+// a time range and the account table to skip segments without a given
+// account, or to go straight to its records; the block table lets them read
+// a segment newest block first.
+class TransactionSegment {
+public:
+    enum : uint8_t {
+        TYPE_TEXT = 0,
+        TYPE_DEPOSIT = 1,
+        TYPE_WITHDRAWAL = 2,
+        TYPE_TRANSFER_OUT = 3,
+        TYPE_TRANSFER_IN = 4,
+        // Both legs in one record: account is the sender, counterparty the
+        // recipient. Earlier logs hold a TRANSFER_OUT/TRANSFER_IN pair.
+        TYPE_TRANSFER = 5
+    };
+    static constexpr char FILE_MAGIC[8] = {'A', 'T', 'M', 'T', 'X', 'L', 'G', '2'};
+    static constexpr size_t MAX_BLOCK_RECORDS = 65535;
+
+    enum : uint32_t {
+        SEALED = 1,
+        UNTIMED_RECORDS = 2, // some timestamps are text, outside min/max
+        TEXT_ACCOUNTS = 4,   // some accounts are text, not in the table
+        BLOCK_TABLE = 8      // ends with a block table
+    };
+
+    struct SegmentHeader {
+        uint64_t segmentId;  // random; ties a sidecar index to this file
+        int64_t minTimestampMs;
+        int64_t maxTimestampMs;
+        uint64_t recordCount;
+        uint64_t accountTableOffset;
+        uint32_t accountCount;
+        uint32_t flags;
+    };
+    static_assert(sizeof(SegmentHeader) == 48, "SegmentHeader layout is part of the file format");
+
+    struct AccountEntry {
+        uint32_t card;
+        uint32_t count;
+        uint64_t firstLocation; // index into the location array
+    };
+    static_assert(sizeof(AccountEntry) == 16, "AccountEntry layout is part of the file format");
+
+    static constexpr size_t DATA_START = sizeof(FILE_MAGIC) + sizeof(SegmentHeader);
+
+    // A record's position: its block's file offset and its row in the block.
+    static uint64_t location(uint64_t block, uint32_t row) { return block << 16 | row; }
+    static uint64_t blockOf(uint64_t location) { return location >> 16; }
+    static uint32_t rowOf(uint64_t location) { return static_cast<uint32_t>(location & 0xffff); }
+
+    // A numeric account as text, zero-padded to digits.
+    static std::string accountText(uint32_t card, uint8_t digits) {
+        std::string text(digits, '0');
+        for (size_t i = digits; i-- > 0 && card > 0; card /= 10) text[i] = static_cast<char>('0' + card % 10);
+        return text;
+    }
+
+    // One decoded record. Text views point into the block it was decoded
+    // from (or the record it was built from).
+    struct Row {
+        uint64_t id{0};          // n of "TXN<n>" unless idText is set
+        std::string_view idText;
+        uint32_t card{0};        // numeric account unless accountText is set
+        uint8_t cardDigits{0};
+        std::string_view accountText;
+        uint8_t type{TYPE_TEXT};
+        std::string_view typeText;
+        // TYPE_TRANSFER only: the recipient, numeric unless
+        // counterpartyText is set.
+        uint32_t counterparty{0};
+        uint8_t counterpartyDigits{0};
+        std::string_view counterpartyText;
+        int64_t amountCents{0};
+        int64_t timestampMs{0};  // unless timestampText is set
+        std::string_view timestampText;
+
+        std::string transactionID() const {
+            return idText.empty() ? "TXN" + std::to_string(id) : std::string(idText);
+        }
+
+        std::string accountNumber() const {
+            if (!accountText.empty() || cardDigits == 0) return std::string(accountText);
+            return TransactionSegment::accountText(card, cardDigits);
+        }
+
+        std::string counterpartyNumber() const {
+            if (!counterpartyText.empty() || counterpartyDigits == 0) return std::string(counterpartyText);
+            return TransactionSegment::accountText(counterparty, counterpartyDigits);
+        }
+
+        // Whether the record moved money in or out of the account: its
+        // account, or the recipient of a transfer.
+        bool involves(const std::string& number) const {
+            return accountNumber() == number || (type == TYPE_TRANSFER && counterpartyNumber() == number);
+        }
+
+        std::string_view typeName() const { return type == TYPE_TEXT ? typeText : TransactionSegment::typeName(type); }
+        double amount() const { return static_cast<double>(amountCents) / 100.0; }
+
+        std::string timestamp() const {
+            return timestampText.empty() ? TimeFormat::format(timestampMs) : std::string(timestampText);
+        }
+    };
+
+private:
+    enum : uint8_t { TYPE_MASK = 0x0f, ID_TEXT = 0x10, ACCOUNT_TEXT = 0x20, TIME_TEXT = 0x40, COUNTERPARTY_TEXT = 0x80 };
+    enum { COL_FLAGS, COL_IDS, COL_ACCOUNTS, COL_AMOUNTS, COL_TIMESTAMPS, COL_TEXT, COLUMN_COUNT };
+
+    struct BlockHeader {
+        char magic[4];
+        uint32_t count;
+        uint32_t payloadBytes;
+        uint32_t checksum;
+        int64_t baseTimestampMs;
+        uint32_t columnBytes[COLUMN_COUNT];
+    };
+    static_assert(sizeof(BlockHeader) == 48, "BlockHeader layout is part of the file format");
+
+    static constexpr char BLOCK_MAGIC[4] = {'T', 'X', 'B', '1'};
+
+    static uint64_t zigzag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+    static int64_t unzigzag(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    static void putVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out += static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    static bool getVarint(const char*& p, const char* end, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(*p++);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (byte < 0x80) return true;
+        }
+        return false;
+    }
+
+    static void putText(std::string& out, std::string_view text) {
+        putVarint(out, text.size());
+        out.append(text.data(), text.size());
+    }
+
+    static bool getText(const char*& p, const char* end, std::string_view& text) {
+        uint64_t length;
+        if (!getVarint(p, end, length) || length > static_cast<uint64_t>(end - p)) return false;
+        text = std::string_view(p, static_cast<size_t>(length));
+        p += length;
+        return true;
+    }
+
+    static uint32_t checksum(const char* data, size_t size) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    static bool readBlockHeader(const char* data, size_t available, BlockHeader& header) {
+        if (available < sizeof(BlockHeader)) return false;
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, BLOCK_MAGIC, sizeof(BLOCK_MAGIC)) != 0) return false;
+        if (header.count == 0 || header.count > MAX_BLOCK_RECORDS) return false;
+        if (header.payloadBytes > available - sizeof(BlockHeader)) return false;
+        uint64_t columns = 0;
+        for (uint32_t bytes : header.columnBytes) columns += bytes;
+        return columns == header.payloadBytes;
+    }
+
+public:
+    static std::string_view typeName(uint8_t type) {
+        switch (type) {
+        case TYPE_DEPOSIT: return "DEPOSIT";
+        case TYPE_WITHDRAWAL: return "WITHDRAWAL";
+        case TYPE_TRANSFER_OUT: return "TRANSFER_OUT";
+        case TYPE_TRANSFER_IN: return "TRANSFER_IN";
+        case TYPE_TRANSFER: return "TRANSFER";
+        }
+        return "";
+    }
+
+    static uint8_t typeCode(std::string_view name) {
+        for (uint8_t type = TYPE_DEPOSIT; type <= TYPE_TRANSFER; ++type) {
+            if (typeName(type) == name) return type;
+        }
+        return TYPE_TEXT;
+    }
+
+    // An all-digit account number of up to 9 digits as card and digits;
+    // anything else as text.
+    static void parseAccount(std::string_view account, uint32_t& card, uint8_t& digits, std::string_view& text) {
+        bool numeric = !account.empty() && account.size() <= 9;
+        uint32_t number = 0;
+        for (size_t i = 0; numeric && i < account.size(); ++i) {
+            numeric = account[i] >= '0' && account[i] <= '9';
+            number = number * 10 + static_cast<uint32_t>(account[i] - '0');
+        }
+        if (numeric) {
+            card = number;
+            digits = static_cast<uint8_t>(account.size());
+        } else {
+            text = account;
+        }
+    }
+
+    // Fills row from the text form of a record, choosing the compact
+    // encoding for every field that has one. Views keep pointing at the
+    // given text.
+    static void fromText(std::string_view id, std::string_view account, std::string_view type,
+                         int64_t amountCents, std::string_view timestamp, Row& row) {
+        row = Row();
+        uint64_t number = 0;
+        bool numericId = id.size() > 3 && id.size() <= 22 && id.compare(0, 3, "TXN") == 0 &&
+                         (id[3] != '0' || id.size() == 4);
+        for (size_t i = 3; numericId && i < id.size(); ++i) {
+            numericId = id[i] >= '0' && id[i] <= '9';
+            number = number * 10 + static_cast<uint64_t>(id[i] - '0');
+        }
+        if (numericId) row.id = number;
+        else row.idText = id;
+
+        parseAccount(account, row.card, row.cardDigits, row.accountText);
+        row.type = typeCode(type);
+        if (row.type == TYPE_TEXT) row.typeText = type;
+        row.amountCents = amountCents;
+        if (!TimeFormat::parse(timestamp, row.timestampMs)) row.timestampText = timestamp;
+    }
+
+    // Parses one line of the CSV form: id,account,type,amount,timestamp, and
+    // for a TRANSFER the recipient after that.
+    static bool parseCsvLine(std::string_view line, Row& row) {
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        std::string_view rest = line;
+        std::string_view id = nextField(rest);
+        std::string_view account = nextField(rest);
+        std::string_view type = nextField(rest);
+        std::string_view amountText = nextField(rest);
+        std::string_view timestamp = nextField(rest);
+        double amount;
+        if (id.empty() || timestamp.empty() || !parseAmount(amountText, amount)) return false;
+        fromText(id, account, type, static_cast<int64_t>(std::llround(amount * 100.0)), timestamp, row);
+        if (row.type == TYPE_TRANSFER) {
+            parseAccount(nextField(rest), row.counterparty, row.counterpartyDigits, row.counterpartyText);
+        }
+        return true;
+    }
+
+    static void appendCsvLine(std::string& out, const Row& row) {
+        char amount[32];
+        std::snprintf(amount, sizeof(amount), "%.2f", row.amount());
+        out += row.transactionID();
+        out += ',';
+        out += row.accountNumber();
+        out += ',';
+        out += row.typeName();
+        out += ',';
+        out += amount;
+        out += ',';
+        out += row.timestamp();
+        if (row.type == TYPE_TRANSFER) {
+            out += ',';
+            out += row.counterpartyNumber();
+        }
+        out += '\n';
+    }
+
+    // What sealing records in the header.
+    struct SegmentStats {
+        int64_t minTimestampMs{INT64_MAX};
+        int64_t maxTimestampMs{INT64_MIN};
+        uint64_t recordCount{0};
+        uint32_t flags{0};
+
+        bool empty() const { return recordCount == 0; }
+        bool timed() const { return minTimestampMs <= maxTimestampMs; }
+
+        void add(const Row& row) {
+            recordCount++;
+            if (!row.timestampText.empty()) {
+                flags |= UNTIMED_RECORDS;
+            } else {
+                minTimestampMs = std::min(minTimestampMs, row.timestampMs);
+                maxTimestampMs = std::max(maxTimestampMs, row.timestampMs);
+            }
+            if (!row.accountText.empty() || row.cardDigits == 0) flags |= TEXT_ACCOUNTS;
+            if (row.type == TYPE_TRANSFER && (!row.counterpartyText.empty() || row.counterpartyDigits == 0)) {
+                flags |= TEXT_ACCOUNTS;
+            }
+        }
+
+        void merge(const SegmentStats& other) {
+            recordCount += other.recordCount;
+            flags |= other.flags;
+            minTimestampMs = std::min(minTimestampMs, other.minTimestampMs);
+            maxTimestampMs = std::max(maxTimestampMs, other.maxTimestampMs);
+        }
+    };
+
+    // Accumulates records into one block.
+    class BlockBuilder {
+    private:
+        std::string columns[COLUMN_COUNT];
+        uint32_t count{0};
+        uint64_t lastId{0};
+        int64_t baseTimestampMs{0};
+        int64_t lastTimestampMs{0};
+        bool haveTimestamp{false};
+
+    public:
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        size_t bytes() const {
+            size_t total = sizeof(BlockHeader);
+            for (const std::string& column : columns) total += column.size();
+            return total;
+        }
+
+        void add(const Row& row) {
+            uint8_t flags = row.type & TYPE_MASK;
+            std::string& text = columns[COL_TEXT];
+            if (!row.idText.empty()) {
+                flags |= ID_TEXT;
+                putText(text, row.idText);
+            } else {
+                putVarint(columns[COL_IDS], zigzag(static_cast<int64_t>(row.id - lastId)));
+                lastId = row.id;
+            }
+            if (!row.accountText.empty() || row.cardDigits == 0) {
+                flags |= ACCOUNT_TEXT;
+                putText(text, row.accountText);
+            } else {
+                putVarint(columns[COL_ACCOUNTS], static_cast<uint64_t>(row.card) * 16 + row.cardDigits);
+            }
+            if (row.type == TYPE_TRANSFER) {
+                if (!row.counterpartyText.empty() || row.counterpartyDigits == 0) {
+                    flags |= COUNTERPARTY_TEXT;
+                    putText(text, row.counterpartyText);
+                } else {
+                    putVarint(columns[COL_ACCOUNTS], static_cast<uint64_t>(row.counterparty) * 16 + row.counterpartyDigits);
+                }
+            }
+            if (row.type == TYPE_TEXT) putText(text, row.typeText);
+            putVarint(columns[COL_AMOUNTS], zigzag(row.amountCents));
+            if (!row.timestampText.empty()) {
+                flags |= TIME_TEXT;
+                putText(text, row.timestampText);
+            } else {
+                if (!haveTimestamp) {
+                    baseTimestampMs = lastTimestampMs = row.timestampMs;
+                    haveTimestamp = true;
+                }
+                putVarint(columns[COL_TIMESTAMPS], zigzag(row.timestampMs - lastTimestampMs));
+                lastTimestampMs = row.timestampMs;
+            }
+            columns[COL_FLAGS] += static_cast<char>(flags);
+            count++;
+        }
+
+        // Appends the finished block to out and starts a new one.
+        void finish(std::string& out) {
+            BlockHeader header{};
+            std::memcpy(header.magic, BLOCK_MAGIC, sizeof(BLOCK_MAGIC));
+            header.count = count;
+            header.baseTimestampMs = baseTimestampMs;
+            size_t start = out.size();
+            out.append(sizeof(BlockHeader), '\0');
+            for (int c = 0; c < COLUMN_COUNT; ++c) {
+                header.columnBytes[c] = static_cast<uint32_t>(columns[c].size());
+                header.payloadBytes += header.columnBytes[c];
+                out += columns[c];
+                columns[c].clear();
+            }
+            header.checksum = checksum(out.data() + start + sizeof(BlockHeader), header.payloadBytes);
+            std::memcpy(&out[start], &header, sizeof(header));
+            count = 0;
+            lastId = 0;
+            haveTimestamp = false;
+        }
+    };
+
+    // Size of the block at data, or 0 if there is no complete block there.
+    // verify also checks the payload checksum.
+    static size_t blockBytes(const char* data, size_t available, bool verify) {
+        BlockHeader header;
+        if (!readBlockHeader(data, available, header)) return 0;
+        if (verify && checksum(data + sizeof(BlockHeader), header.payloadBytes) != header.checksum) return 0;
+        return sizeof(BlockHeader) + header.payloadBytes;
+    }
+
+    // Number of records in the block at data, or 0 if there is no block
+    // there; the block is not decoded.
+    static uint32_t blockRecords(const char* data, size_t available) {
+        BlockHeader header;
+        return readBlockHeader(data, available, header) ? header.count : 0;
+    }
+
+    // Decodes the block at data into rows (replacing their contents).
+    static bool decode(const char* data, size_t available, std::vector<Row>& rows) {
+        BlockHeader header;
+        if (!readBlockHeader(data, available, header)) return false;
+        const char* begin[COLUMN_COUNT];
+        const char* end[COLUMN_COUNT];
+        const char* p = data + sizeof(BlockHeader);
+        for (int c = 0; c < COLUMN_COUNT; ++c) {
+            begin[c] = p;
+            p += header.columnBytes[c];
+            end[c] = p;
+        }
+        if (header.columnBytes[COL_FLAGS] != header.count) return false;
+
+        rows.resize(header.count);
+        uint64_t lastId = 0;
+        int64_t lastTimestampMs = header.baseTimestampMs;
+        const char* ids = begin[COL_IDS];
+        const char* accounts = begin[COL_ACCOUNTS];
+        const char* amounts = begin[COL_AMOUNTS];
+        const char* timestamps = begin[COL_TIMESTAMPS];
+        const char* text = begin[COL_TEXT];
+        uint64_t value;
+        for (uint32_t i = 0; i < header.count; ++i) {
+            Row& row = rows[i];
+            row = Row();
+            uint8_t flags = static_cast<uint8_t>(begin[COL_FLAGS][i]);
+            row.type = flags & TYPE_MASK;
+            if (flags & ID_TEXT) {
+                if (!getText(text, end[COL_TEXT], row.idText)) return false;
+            } else {
+                if (!getVarint(ids, end[COL_IDS], value)) return false;
+                lastId += static_cast<uint64_t>(unzigzag(value));
+                row.id = lastId;
+            }
+            if (flags & ACCOUNT_TEXT) {
+                if (!getText(text, end[COL_TEXT], row.accountText)) return false;
+            } else {
+                if (!getVarint(accounts, end[COL_ACCOUNTS], value)) return false;
+                row.card = static_cast<uint32_t>(value / 16);
+                row.cardDigits = static_cast<uint8_t>(value % 16);
+            }
+            if (row.type == TYPE_TRANSFER) {
+                if (flags & COUNTERPARTY_TEXT) {
+                    if (!getText(text, end[COL_TEXT], row.counterpartyText)) return false;
+                } else {
+                    if (!getVarint(accounts, end[COL_ACCOUNTS], value)) return false;
+                    row.counterparty = static_cast<uint32_t>(value / 16);
+                    row.counterpartyDigits = static_cast<uint8_t>(value % 16);
+                }
+            }
+            if (row.type == TYPE_TEXT && !getText(text, end[COL_TEXT], row.typeText)) return false;
+            if (!getVarint(amounts, end[COL_AMOUNTS], value)) return false;
+            row.amountCents = unzigzag(value);
+            if (flags & TIME_TEXT) {
+                if (!getText(text, end[COL_TEXT], row.timestampText)) return false;
+            } else {
+                if (!getVarint(timestamps, end[COL_TIMESTAMPS], value)) return false;
+                lastTimestampMs += unzigzag(value);
+                row.timestampMs = lastTimestampMs;
+            }
+        }
+        return true;
+    }
+
+    // Walks the blocks of a segment file image from offset onwards, calling
+    // fn(blockOffset, block, bytes). Returns the end of the last complete
+    // block; in an unsealed segment anything past it is a torn write.
+    template <typename Fn>
+    static size_t forEachBlock(const char* data, size_t size, size_t offset, Fn&& fn) {
+        if (offset < DATA_START) offset = DATA_START;
+        while (offset < size) {
+            size_t bytes = blockBytes(data + offset, size - offset, false);
+            if (bytes == 0) break;
+            fn(static_cast<uint64_t>(offset), data + offset, bytes);
+            offset += bytes;
+        }
+        return offset;
+    }
+
+    static bool readHeader(const char* data, size_t size, SegmentHeader& header) {
+        if (size < DATA_START || std::memcmp(data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) return false;
+        std::memcpy(&header, data + sizeof(FILE_MAGIC), sizeof(header));
+        if (header.flags & SEALED) {
+            uint64_t tableBytes = static_cast<uint64_t>(header.accountCount) * sizeof(AccountEntry);
+            return header.accountTableOffset >= DATA_START && header.accountTableOffset <= size &&
+                   tableBytes <= size - header.accountTableOffset;
+        }
+        return true;
+    }
+
+    // The start of a new, empty segment file.
+    static std::string newFile(uint64_t segmentId) {
+        SegmentHeader header{};
+        header.segmentId = segmentId;
+        header.minTimestampMs = INT64_MAX;
+        header.maxTimestampMs = INT64_MIN;
+        std::string bytes(FILE_MAGIC, sizeof(FILE_MAGIC));
+        bytes.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        return bytes;
+    }
+
+    // End of the block data: the account table of a sealed segment, else
+    // the file size.
+    static size_t blocksEnd(const SegmentHeader& header, size_t size) {
+        return (header.flags & SEALED) ? static_cast<size_t>(header.accountTableOffset) : size;
+    }
+
+    // The sealed header for an account table appended after the last block
+    // (at tableOffset), followed by its locations and the block table. table
+    // must be sorted by card and index into locations.
+    static SegmentHeader sealedHeader(uint64_t segmentId, const SegmentStats& stats, uint64_t tableOffset,
+                                      const std::vector<AccountEntry>& table) {
+        SegmentHeader header{};
+        header.segmentId = segmentId;
+        header.minTimestampMs = stats.minTimestampMs;
+        header.maxTimestampMs = stats.maxTimestampMs;
+        header.recordCount = stats.recordCount;
+        header.accountTableOffset = tableOffset;
+        header.accountCount = static_cast<uint32_t>(table.size());
+        header.flags = stats.flags | SEALED | BLOCK_TABLE;
+        return header;
+    }
+
+    // The block table of a sealed segment: offsets points at count block
+    // offsets, oldest first. False for segments sealed without one.
+    static bool blockTable(const char* data, size_t size, const SegmentHeader& header, const char*& offsets,
+                           uint64_t& count) {
+        if (!(header.flags & SEALED) || !(header.flags & BLOCK_TABLE) ||
+            size < header.accountTableOffset + sizeof(uint64_t)) {
+            return false;
+        }
+        std::memcpy(&count, data + size - sizeof(uint64_t), sizeof(count));
+        if (count > (size - sizeof(uint64_t) - header.accountTableOffset) / sizeof(uint64_t)) return false;
+        offsets = data + size - sizeof(uint64_t) - count * sizeof(uint64_t);
+        return true;
+    }
+
+    static uint64_t blockOffset(const char* offsets, uint64_t i) {
+        uint64_t offset;
+        std::memcpy(&offset, offsets + i * sizeof(uint64_t), sizeof(offset));
+        return offset;
+    }
+
+    // Whether a sealed segment may hold records in [fromMs, toMs].
+    static bool overlaps(const SegmentHeader& header, int64_t fromMs, int64_t toMs) {
+        return header.minTimestampMs <= toMs && header.maxTimestampMs >= fromMs;
+    }
+
+    // A card's entry in the account table of a sealed segment; false if
+    // the segment has no records for it.
+    static bool accountEntry(const char* data, size_t size, const SegmentHeader& header, uint32_t card,
+                             AccountEntry& entry) {
+        const char* table = data + header.accountTableOffset;
+        const char* locationBase = table + static_cast<size_t>(header.accountCount) * sizeof(AccountEntry);
+        size_t lo = 0, hi = header.accountCount;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            std::memcpy(&entry, table + mid * sizeof(AccountEntry), sizeof(entry));
+            if (entry.card < card) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo == header.accountCount) return false;
+        std::memcpy(&entry, table + lo * sizeof(AccountEntry), sizeof(entry));
+        size_t available = static_cast<size_t>(data + size - locationBase) / sizeof(uint64_t);
+        return entry.card == card && entry.firstLocation <= available && entry.count <= available - entry.firstLocation;
+    }
+
+    // Locations of a card's records in a sealed segment, oldest first; empty
+    // if the segment has none.
+    static std::vector<uint64_t> locationsFor(const char* data, size_t size, const SegmentHeader& header,
+                                              uint32_t card) {
+        std::vector<uint64_t> locations;
+        AccountEntry entry;
+        if (!accountEntry(data, size, header, card, entry)) return locations;
+        const char* locationBase = data + header.accountTableOffset +
+                                   static_cast<size_t>(header.accountCount) * sizeof(AccountEntry);
+        locations.resize(entry.count);
+        std::memcpy(locations.data(), locationBase + entry.firstLocation * sizeof(uint64_t),
+                    entry.count * sizeof(uint64_t));
+        return locations;
+    }
+};
+
+#endif // TRANSACTIONSEGMENT_H
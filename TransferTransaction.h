@@ -0,0 +1,15 @@
+#ifndef TRANSFERTRANSACTION_H
+#define TRANSFERTRANSACTION_H
+
+#include "Transaction.h"
+
+// A Transaction tagged Transfer, carrying both legs: money leaves accNum
+// and reaches recipient. Logged as one record; both accounts' histories
+// show it.
+class TransferTransaction : public Transaction {
+public:
+    TransferTransaction(uint64_t transID, const std::string& accNum, const std::string& recipient, double amt)
+        : Transaction(Type::Transfer, transID, accNum, amt, recipient) {}
+};
+
+#endif // TRANSFERTRANSACTION_H
\ No newline at end of file
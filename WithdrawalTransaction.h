@@ -3,26 +3,12 @@
 
 #include "Transaction.h"
 
+// A Transaction tagged Withdrawal; adds no state, so it can be stored as a
+// plain Transaction.
 class WithdrawalTransaction : public Transaction {
 public:
-    WithdrawalTransaction(const std::string& transID, const std::string& accNum, double amt)
-        : Transaction(transID, accNum, amt) {}
-
-    std::string printReceipt() const override {
-        std::stringstream ss;
-        ss << "======== WITHDRAWAL RECEIPT =========\n";
-        ss << "Transaction ID: " << transactionID << "\n";
-        ss << "Account Number: " << accountNumber << "\n";
-        ss << "Type: WITHDRAWAL\n";
-        ss << "Amount: $" << std::fixed << std::setprecision(2) << amount << "\n";
-        ss << "Date/Time: " << timestamp << "\n";
-        ss << "=====================================\n";
-        return ss.str();
-    }
-
-    std::string getType() const override {
-        return "WITHDRAWAL";
-    }
+    WithdrawalTransaction(uint64_t transID, const std::string& accNum, double amt)
+        : Transaction(Type::Withdrawal, transID, accNum, amt) {}
 };
 
 #endif // WITHDRAWALTRANSACTION_H
\ No newline at end of file
@@ -0,0 +1,90 @@
+// Throughput of concurrent ATM-style sessions on one Bank as threads are
+// added: each thread runs a mix of transfers, deposit/withdraw pairs and PIN
+// checks over random accounts.
+//
+//   BankScalingBenchmark [maxThreads=2*cores] [accounts=100000] [opsPerThread=200000] [shards=16]
+//
+// Writes bank_accounts.dat in the working directory (and removes it).
+#include "Bank.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static void removeBankFiles() {
+    for (const char* name : {"bank_accounts.dat", "bank_accounts.journal"}) std::remove(name);
+}
+
+int main(int argc, char* argv[]) {
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned maxThreads = argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 2 * cores;
+    const size_t accounts = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+    const size_t opsPerThread = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 200000;
+    const unsigned shards = argc > 4 ? static_cast<unsigned>(std::strtoul(argv[4], nullptr, 10)) : 16;
+
+    std::vector<std::string> cards(accounts);
+    for (size_t i = 0; i < accounts; ++i) cards[i] = std::to_string(1000000 + i);
+
+    std::cout << cores << " hardware threads, " << accounts << " accounts, " << shards << " shards\n"
+              << "threads      ops/s   speedup\n";
+    // 1, 2, 4, ... and maxThreads itself.
+    std::vector<unsigned> threadCounts;
+    for (unsigned n = 1; n < maxThreads; n *= 2) threadCounts.push_back(n);
+    threadCounts.push_back(std::max(1u, maxThreads));
+    double single = 0.0;
+    for (unsigned threadCount : threadCounts) {
+        removeBankFiles();
+        {
+            std::FILE* file = std::fopen("bank_accounts.dat", "wb");
+            if (!file) {
+                std::cerr << "cannot write bank_accounts.dat\n";
+                return 1;
+            }
+            for (const std::string& card : cards) std::fprintf(file, "%s,1234,100.00,Checking Account,Holder,0,0\n", card.c_str());
+            std::fclose(file);
+        }
+        Bank::Options options;
+        options.format = Bank::StorageFormat::Csv;
+        options.shardCount = shards;
+        Bank bank(options);
+
+        auto start = Clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&bank, &cards, opsPerThread, t] {
+                std::mt19937 rng(t + 1);
+                for (size_t op = 0; op < opsPerThread; ++op) {
+                    const std::string& a = cards[rng() % cards.size()];
+                    const std::string& b = cards[rng() % cards.size()];
+                    switch (op % 4) {
+                    case 0:
+                    case 1:
+                        bank.transfer(a, b, 1.25);
+                        break;
+                    case 2:
+                        bank.deposit(a, 2.50);
+                        bank.withdraw(a, 2.50);
+                        break;
+                    default:
+                        bank.verifyPIN(a, "1234");
+                        break;
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        const double opsPerSecond = static_cast<double>(opsPerThread) * threadCount / seconds;
+        if (threadCount == 1) single = opsPerSecond;
+        std::printf("%7u %10.0f   %6.2fx\n", threadCount, opsPerSecond, opsPerSecond / single);
+    }
+    removeBankFiles();
+    return 0;
+}
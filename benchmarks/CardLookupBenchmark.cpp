@@ -0,0 +1,90 @@
+// Account lookup by card number: the old std::map<std::string> index
+// against CardMap, then a Bank loaded from a snapshot of the same size.
+//
+//   CardLookupBenchmark [accounts=1800000] [lookups=5000000]
+//
+// Writes bank_accounts.dat in the working directory (and removes it).
+#include "Bank.h"
+#include "CardMap.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    const size_t accounts = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1800000;
+    const size_t lookups = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5000000;
+
+    // Distinct random 7-digit card numbers, and the lookups as text since
+    // that is what sessions pass in.
+    std::mt19937 rng(42);
+    std::vector<uint32_t> cards;
+    {
+        std::vector<bool> used(9000000, false);
+        while (cards.size() < accounts && cards.size() < used.size()) {
+            uint32_t card = 1000000 + rng() % 9000000;
+            if (used[card - 1000000]) continue;
+            used[card - 1000000] = true;
+            cards.push_back(card);
+        }
+    }
+    std::vector<std::string> queries(lookups);
+    for (std::string& query : queries) query = std::to_string(cards[rng() % cards.size()]);
+
+    size_t hits = 0;
+    {
+        std::map<std::string, uint32_t> index;
+        for (uint32_t card : cards) index.emplace(std::to_string(card), card);
+        auto start = Clock::now();
+        for (const std::string& query : queries) hits += index.find(query) != index.end();
+        std::cout << "std::map<std::string>      " << secondsSince(start) * 1e9 / lookups << " ns/lookup\n";
+    }
+    {
+        CardMap<uint32_t> index;
+        index.reserve(cards.size());
+        for (uint32_t card : cards) index[card] = card;
+        auto start = Clock::now();
+        for (const std::string& query : queries) {
+            uint32_t card = 0;
+            hits += BinaryAccountStore::parseCardNumber(query, card) && index.find(card) != nullptr;
+        }
+        std::cout << "CardMap (incl. parsing)    " << secondsSince(start) * 1e9 / lookups << " ns/lookup\n";
+    }
+
+    {
+        std::FILE* file = std::fopen("bank_accounts.dat", "wb");
+        if (!file) {
+            std::cerr << "cannot write bank_accounts.dat\n";
+            return 1;
+        }
+        for (uint32_t card : cards) std::fprintf(file, "%u,1234,100.00,Checking Account,Holder %u,0,0\n", card, card);
+        std::fclose(file);
+    }
+    for (bool lazy : {false, true}) {
+        Bank::Options options;
+        options.format = Bank::StorageFormat::Csv;
+        options.lazyLoad = lazy;
+        auto start = Clock::now();
+        Bank bank(options);
+        double loadSeconds = secondsSince(start);
+        start = Clock::now();
+        for (const std::string& query : queries) hits += bank.accountExists(query);
+        std::cout << (lazy ? "Bank, lazy index:  " : "Bank, eager load:  ") << loadSeconds << " s to load "
+                  << bank.getAccountCount() << " accounts, " << secondsSince(start) * 1e9 / lookups
+                  << " ns/accountExists\n";
+    }
+    std::remove("bank_accounts.dat");
+    std::remove("bank_accounts.journal");
+    std::cout << "(" << hits << " hits)\n";
+    return 0;
+}
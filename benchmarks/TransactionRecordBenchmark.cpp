@@ -0,0 +1,70 @@
+// Memory per record and time for TransactionLog::readTransactions() over the
+// whole log.
+//
+//   TransactionRecordBenchmark [records=2000000]
+//
+// Writes the transaction log in the working directory (and removes it).
+// Heap use is measured with mallinfo2 where glibc has it.
+#include "DepositTransaction.h"
+#include "TransactionLog.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HAVE_MALLINFO2 1
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static size_t heapInUse() {
+#ifdef HAVE_MALLINFO2
+    // Large blocks come from mmap and are counted apart.
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+static void removeLog() {
+    std::error_code error;
+    for (const char* name : {"transaction_log.bin", "transaction_log.idx", "transaction_log.csv"}) {
+        std::filesystem::remove(name, error);
+    }
+    std::filesystem::remove_all("transaction_log_segments", error);
+}
+
+int main(int argc, char* argv[]) {
+    const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+
+    removeLog();
+    for (size_t i = 0; i < count; ++i) {
+        DepositTransaction deposit(i + 1, std::to_string(1000000 + i % 1000), 10.0 + static_cast<double>(i % 9000) / 100);
+        TransactionLog::logTransaction(deposit);
+    }
+    TransactionLog::flush();
+
+    size_t heapBefore = heapInUse();
+    auto start = Clock::now();
+    std::vector<TransactionRecord> records = TransactionLog::readTransactions();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    size_t heap = heapInUse() - heapBefore;
+
+    std::cout << records.size() << " records in " << seconds * 1000 << " ms\n"
+              << "sizeof(TransactionRecord) " << sizeof(TransactionRecord) << " B\n";
+#ifdef HAVE_MALLINFO2
+    std::cout << "heap " << heap / (1024.0 * 1024.0) << " MB, "
+              << static_cast<double>(heap) / (records.empty() ? 1 : records.size()) << " B/record\n";
+#else
+    (void)heap;
+    std::cout << "heap: mallinfo2 not available\n";
+#endif
+    records.clear();
+    records.shrink_to_fit();
+    removeLog();
+    return 0;
+}
@@ -1,7 +1,129 @@
 #include "AtmInterface.h"
 #include <iostream>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--convert-accounts") {
+        size_t imported = 0;
+        if (!Bank::convertToBinary(imported)) {
+            std::cerr << "Error: could not convert bank_accounts.dat to bank_accounts.bin" << std::endl;
+            return 1;
+        }
+        std::cout << "Converted " << imported << " accounts to bank_accounts.bin\n";
+        return 0;
+    }
+    if ((mode == "--import-log" || mode == "--export-log") && argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " " << mode << " <file.csv>" << std::endl;
+        return 1;
+    }
+    if (mode == "--archive-log") {
+        long days = argc > 2 ? std::atol(argv[2]) : 0;
+        if (days <= 0) {
+            std::cerr << "Usage: " << argv[0] << " --archive-log <days>" << std::endl;
+            return 1;
+        }
+        auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        size_t archived = TransactionLog::archiveSegments(now - days * 24LL * 60 * 60 * 1000);
+        std::cout << "Archived " << archived << " transaction log segments\n";
+        return 0;
+    }
+    if (mode == "--batch-transfer") {
+        if (argc < 4) {
+            std::cerr << "Usage: " << argv[0] << " --batch-transfer <in.csv> <results.csv>" << std::endl;
+            return 1;
+        }
+        std::vector<Bank::TransferRequest> requests;
+        if (!Bank::readTransferBatch(argv[2], requests)) {
+            std::cerr << "Error: could not read " << argv[2] << std::endl;
+            return 1;
+        }
+        auto start = std::chrono::steady_clock::now();
+        Bank bank;
+        // Batch jobs have a node id of their own, which --atm-id refuses.
+        TransactionIdGenerator transactionIds(TransactionIdGenerator::BATCH_NODE);
+        size_t transferred = 0;
+        // The log is written and flushed before the balances are committed,
+        // so a crash in between leaves logged transfers whose balances were
+        // lost, never changed balances with no log entry.
+        std::vector<Bank::TransferResult> results =
+            bank.transferBatch(requests, 0, [&](const std::vector<Bank::TransferResult>& applied) {
+                for (size_t i = 0; i < requests.size(); ++i) {
+                    if (applied[i] != Bank::TransferResult::Ok) continue;
+                    TransferTransaction trans(transactionIds.next(), requests[i].fromAccount, requests[i].toAccount,
+                                              requests[i].amount);
+                    TransactionLog::logTransaction(trans);
+                    transferred++;
+                }
+                TransactionLog::flush();
+            });
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!Bank::writeTransferResults(argv[3], requests, results)) {
+            std::cerr << "Error: could not write " << argv[3] << std::endl;
+            return 1;
+        }
+        std::cout << "Transferred " << transferred << " of " << requests.size() << " in " << seconds
+                  << "s; results in " << argv[3] << "\n";
+        return 0;
+    }
+    if (mode == "--end-of-day") {
+        char* end = nullptr;
+        double percent = argc > 2 ? std::strtod(argv[2], &end) : -1.0;
+        double fee = CheckingAccount::DEFAULT_OVERDRAFT_FEE;
+        char* feeEnd = nullptr;
+        if (argc > 3) fee = std::strtod(argv[3], &feeEnd);
+        if (argc < 3 || *end != '\0' || !(percent >= 0) || (feeEnd && (*feeEnd != '\0' || !(fee >= 0)))) {
+            std::cerr << "Usage: " << argv[0] << " --end-of-day <interest %> [overdraft fee]" << std::endl;
+            return 1;
+        }
+        Bank bank;
+        Bank::EndOfDayStats stats = bank.runEndOfDay(percent / 100.0, fee);
+        std::cout << "End of day over " << stats.accounts << " accounts in " << stats.seconds << "s: "
+                  << std::fixed << std::setprecision(2) << stats.interestCredited << " credited $"
+                  << stats.interestPaid << " interest, "
+                  << stats.feesCharged << " charged $" << stats.feesCollected << " in overdraft fees\n";
+        return 0;
+    }
+    if (mode == "--import-log") {
+        size_t imported = 0;
+        if (!TransactionLog::importCsv(argv[2], imported)) {
+            std::cerr << "Error: could not read " << argv[2] << std::endl;
+            return 1;
+        }
+        std::cout << "Imported " << imported << " transactions into transaction_log.bin\n";
+        return 0;
+    }
+    if (mode == "--export-log") {
+        size_t exported = 0;
+        if (!TransactionLog::exportCsv(argv[2], exported)) {
+            std::cerr << "Error: could not write " << argv[2] << std::endl;
+            return 1;
+        }
+        std::cout << "Exported " << exported << " transactions to " << argv[2] << "\n";
+        return 0;
+    }
+
+    unsigned long atmId = 0;
+    bool printStats = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--stats") {
+            printStats = true;
+        } else if (option == "--atm-id") {
+            char* end = nullptr;
+            atmId = i + 1 < argc ? std::strtoul(argv[i + 1], &end, 10) : 0;
+            if (i + 1 >= argc || *end != '\0' || atmId >= TransactionIdGenerator::BATCH_NODE) {
+                std::cerr << "Usage: " << argv[0] << " --atm-id <0-" << TransactionIdGenerator::BATCH_NODE - 1 << ">" << std::endl;
+                return 1;
+            }
+            ++i;
+        }
+    }
 
-int main() {
     std::cout << "========================================\n";
     std::cout << "   ATM Simulator - Project Group 40\n";
     std::cout << "   Team Members:\n";
@@ -18,7 +140,7 @@ int main() {
     std::cout << "========================================\n\n";
 
     try {
-        ATMInterface atm;
+        ATMInterface atm(static_cast<uint32_t>(atmId), printStats);
         atm.run();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -0,0 +1,158 @@
+#include "Check.h"
+#include "AccountJournal.h"
+#include "Bank.h"
+#include <vector>
+
+// A torn last line is cut off before the next append instead of being
+// glued to the next row.
+static void appendAfterTornTail() {
+    removeBankFiles();
+    writeFile("bank_accounts.journal", "row-a\n#commit,1\nrow-b-torn");
+    {
+        AccountJournal journal("bank_accounts.journal");
+        std::vector<std::string> rows;
+        CHECK(journal.replay([&rows](const std::string& line, uint64_t) { rows.push_back(line); }) == 1);
+        CHECK(rows == std::vector<std::string>{"row-a"});
+        CHECK(journal.appendGroup("row-c\n", 1) == 16);
+    }
+    CHECK(readFile("bank_accounts.journal") == "row-a\n#commit,1\nrow-c\n#commit,1\n");
+
+    AccountJournal reloaded("bank_accounts.journal");
+    std::vector<std::pair<std::string, uint64_t>> rows;
+    reloaded.replay([&rows](const std::string& line, uint64_t offset) { rows.emplace_back(line, offset); });
+    CHECK(rows.size() == 2);
+    CHECK(rows.size() == 2 && rows[1].first == "row-c" && rows[1].second == 16);
+    std::string line;
+    CHECK(reloaded.readRow(16, line) && line == "row-c");
+}
+
+// The same through the Bank: a deposit committed after a torn row must
+// neither be lost nor resurrect the torn row as another account's data.
+static void bankReloadAfterTornTail() {
+    removeBankFiles();
+    writeFile("bank_accounts.dat",
+              "1111111,1111,50.00,Checking Account,Alice,0,0\n"
+              "2222222,2222,100.00,Checking Account,Bob,0,0\n");
+    writeFile("bank_accounts.journal", "1111111,99");
+    {
+        Bank::Options options;
+        options.format = Bank::StorageFormat::Csv;
+        options.commitThreshold = 1;
+        Bank bank(options);
+        CHECK(bank.deposit("2222222", 5.0));
+    }
+    Bank::Options options;
+    options.format = Bank::StorageFormat::Csv;
+    Bank bank(options);
+    auto alice = bank.getAccount("1111111");
+    auto bob = bank.getAccount("2222222");
+    CHECK(alice && alice->getBalance() == 50.0 && bank.verifyPIN("1111111", "1111"));
+    CHECK(bob && bob->getBalance() == 105.0 && bank.verifyPIN("2222222", "2222"));
+}
+
+// Rows of a group whose commit marker never reached disk are dropped on
+// replay and cut off, so the next group's marker does not adopt them.
+static void appendAfterUncommittedGroup() {
+    removeBankFiles();
+    writeFile("bank_accounts.dat",
+              "1111111,1111,50.00,Checking Account,Alice,0,0\n"
+              "2222222,2222,100.00,Checking Account,Bob,0,0\n");
+    writeFile("bank_accounts.journal",
+              "1111111,1111,60.00,Checking Account,Alice,0,0\n#commit,1\n"
+              "1111111,1111,1234.00,Checking Account,Alice,0,0\n1111111,99");
+    {
+        Bank::Options options;
+        options.format = Bank::StorageFormat::Csv;
+        options.commitThreshold = 1;
+        Bank bank(options);
+        auto alice = bank.getAccount("1111111");
+        CHECK(alice && alice->getBalance() == 60.0);
+        CHECK(bank.deposit("2222222", 5.0));
+    }
+    Bank::Options options;
+    options.format = Bank::StorageFormat::Csv;
+    Bank bank(options);
+    auto alice = bank.getAccount("1111111");
+    auto bob = bank.getAccount("2222222");
+    CHECK(alice && alice->getBalance() == 60.0 && bank.verifyPIN("1111111", "1111"));
+    CHECK(bob && bob->getBalance() == 105.0 && bank.verifyPIN("2222222", "2222"));
+}
+
+// Writes the intent file the binary store leaves when a crash comes after
+// the intent is on disk but before its records are all in the store.
+static void writeIntent(const std::vector<std::pair<uint64_t, BinaryAccountStore::Record>>& entries, bool torn) {
+    std::string bytes;
+    for (const auto& [slot, record] : entries) {
+        bytes.append(reinterpret_cast<const char*>(&slot), sizeof(slot));
+        bytes.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : bytes) hash = (hash ^ c) * 1099511628211ull;
+    if (torn) hash++;
+    const uint64_t count = entries.size();
+    std::string file = "ATMINTN1";
+    file.append(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    writeFile("bank_accounts.bin.intent", file + bytes);
+}
+
+// Both sides of a transfer reach the binary store, or neither does.
+static void binaryGroupSurvivesCrash() {
+    removeBankFiles();
+    writeFile("bank_accounts.dat",
+              "1111111,1111,100.00,Checking Account,Alice,0,0\n"
+              "2222222,2222,100.00,Checking Account,Bob,0,0\n");
+    size_t imported = 0;
+    CHECK(Bank::convertToBinary(imported) && imported == 2);
+    Bank::Options options;
+    options.format = Bank::StorageFormat::Binary;
+    {
+        Bank bank(options);
+        CHECK(bank.transfer("1111111", "2222222", 40.0) == Bank::TransferResult::Ok);
+    }
+
+    // A second transfer of 50.00 whose intent is torn: the store was never
+    // touched, so the intent is ignored.
+    std::vector<std::pair<uint64_t, BinaryAccountStore::Record>> entries;
+    {
+        BinaryAccountStore store;
+        CHECK(store.open("bank_accounts.bin", "bank_accounts.names") && store.size() == 2);
+        for (size_t slot = 0; slot < store.size(); ++slot) {
+            BinaryAccountStore::Record record = store.at(slot);
+            record.balanceCents += record.cardNumber == 1111111 ? -5000 : 5000;
+            entries.emplace_back(slot, record);
+        }
+    }
+    writeIntent(entries, true);
+    {
+        Bank bank(options);
+        auto alice = bank.getAccount("1111111");
+        auto bob = bank.getAccount("2222222");
+        CHECK(alice && alice->getBalance() == 60.0 && bob && bob->getBalance() == 140.0);
+    }
+
+    // The same transfer with its intent on disk and only Alice's side in the
+    // store: the next open finishes it.
+    {
+        BinaryAccountStore store;
+        CHECK(store.open("bank_accounts.bin", "bank_accounts.names"));
+        for (const auto& [slot, record] : entries) {
+            if (record.cardNumber == 1111111) store.at(static_cast<size_t>(slot)) = record;
+        }
+        store.sync();
+    }
+    writeIntent(entries, false);
+    Bank bank(options);
+    auto alice = bank.getAccount("1111111");
+    auto bob = bank.getAccount("2222222");
+    CHECK(alice && alice->getBalance() == 10.0 && bob && bob->getBalance() == 190.0);
+}
+
+int main() {
+    appendAfterTornTail();
+    bankReloadAfterTornTail();
+    appendAfterUncommittedGroup();
+    binaryGroupSurvivesCrash();
+    removeBankFiles();
+    return checkResult("AccountJournalTest");
+}
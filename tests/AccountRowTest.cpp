@@ -0,0 +1,78 @@
+#include "Check.h"
+#include "AccountRow.h"
+
+static bool parses(const char* text, double expected) {
+    double value = -1.0;
+    return parseAmount(text, value) && value == expected;
+}
+
+static bool rejects(const char* text) {
+    double value = 0.0;
+    return !parseAmount(text, value);
+}
+
+static void amounts() {
+    CHECK(parses("123", 123.0));
+    CHECK(parses("-123", -123.0));
+    CHECK(parses("123.4", 123.4));
+    CHECK(parses("123.45", 123.45));
+    CHECK(parses("-0.05", -0.05));
+    CHECK(parses("0.1", 0.1));
+    // older spellings go through strtod
+    CHECK(parses("1e+06", 1e6));
+    CHECK(parses("12.345", 12.345));
+    // cents would overflow a long long; strtod takes these
+    CHECK(parses("92233720368547759.07", 92233720368547759.07));
+    CHECK(parses("-99999999999999999.99", -99999999999999999.99));
+    CHECK(parses("92233720368547757.99", 92233720368547757.99));
+
+    CHECK(rejects(""));
+    CHECK(rejects("-"));
+    CHECK(rejects("abc"));
+    CHECK(rejects("12x"));
+    CHECK(rejects("1.2.3"));
+    // a sign after the decimal point or a repeated sign
+    CHECK(rejects("1.-5"));
+    CHECK(rejects("1.+5"));
+    CHECK(rejects("--5"));
+    CHECK(rejects("-+5"));
+    CHECK(rejects("-5.-5"));
+    CHECK(rejects("+5"));
+    // what strtod alone would accept
+    CHECK(rejects(" 5"));
+    CHECK(rejects("\t5"));
+    CHECK(rejects("- 5"));
+    CHECK(rejects("inf"));
+    CHECK(rejects("-infinity"));
+    CHECK(rejects("nan"));
+    CHECK(rejects("NAN"));
+    CHECK(rejects("0x10"));
+    CHECK(rejects("1e999"));
+}
+
+static void rows() {
+    AccountRow row;
+    CHECK(parseAccountRow("1234567,1111,250.50,Savings Account,Alice,1,2", row));
+    CHECK(row.accountNumber == "1234567" && row.pin == "1111" && row.balance == 250.5);
+    CHECK(row.accountType == "Savings Account" && row.holderName == "Alice");
+    CHECK(row.locked && row.failedAttempts == 2 && !row.hasOverdraftLimit);
+
+    CHECK(parseAccountRow("1234567,1111,-50,Checking Account,Bob,0,0,1200.00", row));
+    CHECK(row.hasOverdraftLimit && row.overdraftLimit == 1200.0);
+    CHECK(!parseAccountRow("1234567,1111,-50,Checking Account,Bob,0,0,-5", row));
+
+    // older files: CRLF, no attempts column, no name
+    CHECK(parseAccountRow("1234567,1111,10,Checking Account,,0\r", row));
+    CHECK(row.balance == 10.0 && row.holderName == "Unknown" && !row.locked && row.failedAttempts == 0);
+
+    CHECK(!parseAccountRow(",1111,10,Checking Account,Bob,0,0", row));
+    CHECK(!parseAccountRow("1234567,1111,1.-5,Checking Account,Bob,0,0", row));
+    CHECK(!parseAccountRow("1234567,1111,--5,Checking Account,Bob,0,0", row));
+    CHECK(!parseAccountRow("1234567,1111,10,Checking Account,Bob,0,x", row));
+}
+
+int main() {
+    amounts();
+    rows();
+    return checkResult("AccountRowTest");
+}
@@ -0,0 +1,202 @@
+#include "Check.h"
+#include "Bank.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::string cardName(int i) { return std::to_string(1000000 + i); }
+
+static std::string centsText(int64_t cents) {
+    char text[32];
+    const uint64_t magnitude = cents < 0 ? 0 - static_cast<uint64_t>(cents) : static_cast<uint64_t>(cents);
+    std::snprintf(text, sizeof(text), "%s%" PRIu64 ".%02" PRIu64, cents < 0 ? "-" : "", magnitude / 100, magnitude % 100);
+    return text;
+}
+
+static size_t commitGroups() {
+    size_t groups = 0;
+    const std::string journal = readFile("bank_accounts.journal");
+    for (size_t at = journal.find("#commit"); at != std::string::npos; at = journal.find("#commit", at + 1)) groups++;
+    return groups;
+}
+
+// Balance of every account, by index.
+static std::vector<int64_t> balances(Bank& bank, int accounts) {
+    std::vector<int64_t> cents(accounts, INT64_MIN);
+    bank.forEachRow([&cents](const AccountTable& table, size_t row) {
+        cents[std::stoi(table.accountNumber(row)) - 1000000] = table.cents(row);
+    });
+    return cents;
+}
+
+static Bank::Options eagerOptions() {
+    Bank::Options options;
+    options.format = Bank::StorageFormat::Csv;
+    options.commitThreshold = 1 << 30;
+    options.commitIntervalMs = 1 << 30;
+    return options;
+}
+
+// A batch gives the results and balances of the same transfers made one by
+// one with Bank::transfer, rejected ones included, and reaches disk as one
+// commit group. Wave 0 is large enough to be split across workers.
+static void batchMatchesSequential() {
+    const int accounts = 50000;
+    std::string snapshot;
+    for (int i = 0; i < accounts; ++i) {
+        // Savings accounts cannot overdraw and some checking accounts only a
+        // little, so plenty of transfers run out of funds.
+        const char* type = i % 3 == 0 ? "Savings Account" : "Checking Account";
+        snapshot += cardName(i) + ",1234," + centsText(i % 5000) + "," + type + ",Holder," + (i % 97 == 0 ? "1" : "0") +
+                    ",0" + (i % 3 == 1 ? ",10.00" : "") + "\n";
+    }
+    std::mt19937 rng(11);
+    std::vector<Bank::TransferRequest> requests;
+    for (int i = 0; i < 60000; ++i) {
+        Bank::TransferRequest request;
+        request.fromAccount = cardName(static_cast<int>(rng() % accounts));
+        request.toAccount = cardName(static_cast<int>(rng() % accounts));
+        request.amount = static_cast<double>(1 + rng() % 4000) / 100.0;
+        switch (i % 50) {
+        case 0: request.toAccount = request.fromAccount; break;
+        case 1: request.fromAccount = "9999999"; break;
+        case 2: request.toAccount = "not-a-card"; break;
+        case 3: request.amount = -5.0; break;
+        case 4: request.amount = 0.001; break;
+        default: break;
+        }
+        requests.push_back(request);
+    }
+
+    removeBankFiles();
+    writeFile("bank_accounts.dat", snapshot);
+    std::vector<Bank::TransferResult> expected;
+    std::vector<int64_t> expectedCents;
+    {
+        Bank bank(eagerOptions());
+        for (const Bank::TransferRequest& request : requests) {
+            expected.push_back(bank.transfer(request.fromAccount, request.toAccount, request.amount));
+        }
+        expectedCents = balances(bank, accounts);
+    }
+
+    removeBankFiles();
+    writeFile("bank_accounts.dat", snapshot);
+    {
+        Bank bank(eagerOptions());
+        const size_t groups = commitGroups();
+        std::vector<Bank::TransferResult> results = bank.transferBatch(requests, 4);
+        CHECK(results == expected);
+        CHECK(balances(bank, accounts) == expectedCents);
+        CHECK(commitGroups() == groups + 1);
+    }
+    size_t kinds = 0;
+    for (auto result : {Bank::TransferResult::Ok, Bank::TransferResult::InsufficientFunds,
+                        Bank::TransferResult::SenderLocked, Bank::TransferResult::RecipientLocked}) {
+        kinds += std::count(expected.begin(), expected.end(), result) > 0;
+    }
+    CHECK(kinds == 4);
+    Bank reloaded(eagerOptions());
+    CHECK(balances(reloaded, accounts) == expectedCents);
+}
+
+struct Row {
+    bool savings;
+    int64_t cents;
+    int64_t limitCents;
+};
+
+// What applyRate and CheckingAccount's fee rule give, one account at a time.
+static void referenceEndOfDay(std::vector<Row>& rows, double rate, int64_t feeCents, Bank::EndOfDayStats& totals) {
+    int64_t interest = 0, fees = 0;
+    for (Row& row : rows) {
+        const int64_t before = row.cents;
+        if (row.savings) {
+            row.cents += std::llround(static_cast<double>(row.cents) * rate);
+            if (row.cents != before) totals.interestCredited++;
+            interest += row.cents - before;
+        } else if (row.cents < 0) {
+            row.cents -= std::min(feeCents, std::max<int64_t>(row.cents + row.limitCents, 0));
+            if (row.cents != before) totals.feesCharged++;
+            fees += before - row.cents;
+        }
+    }
+    totals.interestPaid = AccountTable::fromCents(interest);
+    totals.feesCollected = AccountTable::fromCents(fees);
+}
+
+// Interest rounding (halves included, both signs) and the fee cap against
+// each row's own overdraft limit match a scalar reference, for balances in
+// the vectorized range and past it, over enough rows that shards run on
+// several threads. A run is one commit group.
+static void endOfDayMatchesReference() {
+    const int accounts = 140000;
+    std::mt19937 rng(5);
+    std::vector<Row> rows(accounts);
+    std::string snapshot;
+    const int64_t limits[] = {0, 2500, 10050, 50000, 2000000000000000};
+    for (int i = 0; i < accounts; ++i) {
+        Row& row = rows[i];
+        row.savings = i % 2 == 0;
+        switch (i % 7) {
+        case 0: row.cents = static_cast<int64_t>(rng() % 2000001) - 1000000; break;
+        case 1: row.cents = -static_cast<int64_t>(rng() % 60000); break;
+        case 2: row.cents = 2 * static_cast<int64_t>(rng() % 1000) + 1; break; // odd, so rate 0.5 gives halves
+        case 3: row.cents = -2 * static_cast<int64_t>(rng() % 1000) - 1; break;
+        default: row.cents = static_cast<int64_t>(rng() % 1000000000) * 10000 + rng() % 10000; break;
+        }
+        // A few past the range where the kernel's doubles are exact.
+        if (i % 1000 == 4) row.cents = 3000000000000000 + static_cast<int64_t>(rng());
+        if (i % 1000 == 5) row.cents = -3000000000000000 - static_cast<int64_t>(rng());
+        row.limitCents = limits[i % 5];
+        snapshot += cardName(i) + ",1234," + centsText(row.cents) + "," +
+                    (row.savings ? "Savings Account" : "Checking Account") + ",Holder,0,0";
+        if (row.limitCents != AccountTable::DEFAULT_OVERDRAFT_LIMIT_CENTS) snapshot += "," + centsText(row.limitCents);
+        snapshot += "\n";
+    }
+    removeBankFiles();
+    writeFile("bank_accounts.dat", snapshot);
+
+    Bank bank(eagerOptions());
+    // Start from the balances and limits as loaded, since the largest do
+    // not survive parsing to the cent.
+    bank.forEachRow([&rows](const AccountTable& table, size_t row) {
+        Row& reference = rows[std::stoi(table.accountNumber(row)) - 1000000];
+        reference.cents = table.cents(row);
+        reference.limitCents = table.overdraftLimitCents(row);
+    });
+    const struct {
+        double rate;
+        double fee;
+    } runs[] = {{0.5, 25.0}, {0.0123, 0.07}, {-0.02, 1000.0}};
+    for (const auto& run : runs) {
+        Bank::EndOfDayStats expected;
+        referenceEndOfDay(rows, run.rate, AccountTable::toCents(run.fee), expected);
+        Bank::EndOfDayStats stats = bank.runEndOfDay(run.rate, run.fee, 4);
+        std::vector<int64_t> cents = balances(bank, accounts);
+        size_t mismatches = 0;
+        for (int i = 0; i < accounts; ++i) mismatches += cents[i] != rows[i].cents;
+        CHECK(mismatches == 0);
+        CHECK(stats.accounts == static_cast<size_t>(accounts));
+        CHECK(stats.interestCredited == expected.interestCredited && stats.feesCharged == expected.feesCharged);
+        CHECK(stats.interestPaid == expected.interestPaid && stats.feesCollected == expected.feesCollected);
+        if (&run == &runs[0]) {
+            // Later runs push the journal past the account count, which
+            // folds it into the snapshot; this one starts it.
+            const std::string marker = "#commit," + std::to_string(stats.interestCredited + stats.feesCharged) + "\n";
+            CHECK(commitGroups() == 1 && readFile("bank_accounts.journal").find(marker) != std::string::npos);
+        }
+        if (mismatches > 0) std::cerr << "  rate " << run.rate << ", fee " << run.fee << "\n";
+    }
+}
+
+int main() {
+    batchMatchesSequential();
+    endOfDayMatchesReference();
+    removeBankFiles();
+    return checkResult("BankBatchTest");
+}
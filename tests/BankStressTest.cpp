@@ -0,0 +1,162 @@
+#include "Check.h"
+#include "Bank.h"
+#include "DepositTransaction.h"
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int accounts = 2000;
+static const int threadCount = 8;
+static const int opsPerThread = 4000;
+
+static std::string cardName(int i) { return std::to_string(1000000 + i); }
+
+static void writeSnapshot() {
+    removeBankFiles();
+    std::string text;
+    for (int i = 0; i < accounts; ++i) {
+        text += cardName(i) + ",1234,100.00,Checking Account,Holder,0,0\n";
+    }
+    writeFile("bank_accounts.dat", text);
+}
+
+static int64_t totalCents(Bank& bank) {
+    int64_t total = 0;
+    bank.forEachRow([&total](const AccountTable& table, size_t row) { total += table.cents(row); });
+    return total;
+}
+
+static std::string pinFor(int i) { return std::to_string(1000 + i % 9000); }
+
+static void run(const char* mode, const Bank::Options& options) {
+    writeSnapshot();
+    const int failuresBefore = checkFailures();
+    const int64_t initial = static_cast<int64_t>(accounts) * 10000;
+    std::atomic<int64_t> depositedCents{0};
+    std::atomic<uint64_t> recorded{0};
+    const std::string shared = cardName(0);
+    // Written only by the owning thread, so no two threads share an element.
+    std::vector<char> touched(accounts, 0);
+    {
+        Bank bank(options);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&bank, &depositedCents, &recorded, &shared, &touched, t] {
+                std::mt19937 rng(t);
+                bank.recordFailedPin(shared);
+                for (int op = 0; op < opsPerThread; ++op) {
+                    int a = 1 + static_cast<int>(rng() % (accounts - 1));
+                    int b = 1 + static_cast<int>(rng() % (accounts - 1));
+                    int cents = 100 + static_cast<int>(rng() % 400);
+                    switch (op % 4) {
+                        case 0:
+                        case 1:
+                            bank.transfer(cardName(a), cardName(b), cents / 100.0);
+                            break;
+                        case 2:
+                            if (bank.deposit(cardName(a), cents / 100.0)) {
+                                depositedCents += cents;
+                                recorded += bank.recordHistory(cardName(a), DepositTransaction(op, cardName(a), cents / 100.0));
+                            }
+                            if (bank.withdraw(cardName(a), cents / 100.0)) depositedCents -= cents;
+                            break;
+                        default: {
+                            bank.verifyPIN(cardName(a), "1234");
+                            bank.isAccountLocked(cardName(b));
+                            // PIN and lock changes only go to this thread's
+                            // own accounts (i % threadCount == t), so their
+                            // final state is known.
+                            int owned = a - a % threadCount + t;
+                            if (owned == 0 || owned >= accounts) break;
+                            touched[owned] = 1;
+                            bank.changePin(cardName(owned), pinFor(owned));
+                            if (owned % 3 == 0) {
+                                for (int i = 0; i < Bank::maxPinAttempts; ++i) bank.recordFailedPin(cardName(owned));
+                            } else {
+                                bank.setAccountLock(cardName(owned), false);
+                            }
+                            break;
+                        }
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+        CHECK(totalCents(bank) == initial + depositedCents.load());
+        auto account = bank.getAccount(shared);
+        CHECK(account && account->getFailedLoginAttempts() == threadCount);
+        CHECK(bank.isAccountLocked(shared));
+        if (!options.lazyLoad) {
+            // Evicted accounts drop their history, so only count when all stay.
+            uint64_t added = 0;
+            for (const Bank::HistoryUsage& usage : bank.getHistoryUsage()) added += usage.added;
+            CHECK(added == recorded.load());
+        }
+    }
+
+    Bank reloaded(options);
+    CHECK(reloaded.getAccountCount() == static_cast<size_t>(accounts));
+    CHECK(totalCents(reloaded) == initial + depositedCents.load());
+    CHECK(reloaded.isAccountLocked(shared));
+    int wrongPins = 0;
+    int wrongLocks = 0;
+    for (int i = 1; i < accounts; ++i) {
+        const std::string card = cardName(i);
+        if (!reloaded.verifyPIN(card, touched[i] ? pinFor(i) : "1234")) wrongPins++;
+        if (reloaded.isAccountLocked(card) != (touched[i] && i % 3 == 0)) wrongLocks++;
+    }
+    CHECK(wrongPins == 0);
+    CHECK(wrongLocks == 0);
+    if (checkFailures() > failuresBefore) std::cerr << "  in " << mode << " mode\n";
+}
+
+// A held view keeps reading its row while another thread appends enough
+// accounts to the same shard to grow every column several times over.
+static void viewSurvivesGrowth() {
+    removeBankFiles();
+    writeFile("bank_accounts.dat", cardName(0) + ",1234,100.00,Checking Account,Holder,0,0\n");
+    Bank::Options options;
+    options.format = Bank::StorageFormat::Csv;
+    options.shardCount = 1;
+    options.commitThreshold = 100000;
+    Bank bank(options);
+    std::shared_ptr<Account> view = bank.getAccount(cardName(0));
+    CHECK(view != nullptr);
+    if (!view) return;
+    std::atomic<bool> done{false};
+    std::thread creator([&bank, &done] {
+        for (int i = 1; i < 20000; ++i) bank.createAccount(cardName(i), "1234", "Checking", "Holder", 1.0);
+        done = true;
+    });
+    bool consistent = true;
+    while (!done) {
+        consistent = consistent && view->getAccountNumber() == cardName(0) && view->getBalance() == 100.0;
+        bank.deposit(cardName(0), 1.0);
+        bank.withdraw(cardName(0), 1.0);
+    }
+    creator.join();
+    CHECK(consistent);
+    CHECK(bank.getAccountCount() == 20000);
+}
+
+int main() {
+    viewSurvivesGrowth();
+
+    Bank::Options eager;
+    eager.format = Bank::StorageFormat::Csv;
+    run("eager", eager);
+
+    Bank::Options lazy = eager;
+    lazy.lazyLoad = true;
+    lazy.memoryBudgetBytes = 256 * 230;
+    run("lazy", lazy);
+
+    Bank::Options binary;
+    binary.format = Bank::StorageFormat::Binary;
+    run("binary", binary);
+
+    removeBankFiles();
+    return checkResult("BankStressTest");
+}
@@ -0,0 +1,52 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdio>
+
+// Minimal assertions for the test drivers: a failed CHECK is reported and
+// the driver exits non-zero, but the remaining checks still run. Each
+// driver runs in its own working directory, since the Bank and the
+// transaction log use fixed file names.
+inline int& checkFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                       \
+    do {                                                                                  \
+        if (!(cond)) {                                                                    \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n";    \
+            checkFailures()++;                                                            \
+        }                                                                                 \
+    } while (0)
+
+inline void writeFile(const std::string& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+}
+
+inline std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+// Removes the account files a Bank leaves in the working directory.
+inline void removeBankFiles() {
+    for (const char* name : {"bank_accounts.dat", "bank_accounts.journal", "bank_accounts.bin",
+                             "bank_accounts.bin.intent", "bank_accounts.names", "pending_deposits.dat"}) {
+        std::remove(name);
+    }
+}
+
+inline int checkResult(const char* name) {
+    if (checkFailures() == 0) std::cout << name << ": all checks passed\n";
+    return checkFailures() == 0 ? 0 : 1;
+}
+
+#endif // CHECK_H
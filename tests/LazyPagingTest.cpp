@@ -0,0 +1,88 @@
+#include "Check.h"
+#include "Bank.h"
+#include <string>
+
+static std::string cardName(int i) { return std::to_string(1000000 + i); }
+
+static void writeSnapshot(int accounts) {
+    removeBankFiles();
+    std::string text;
+    for (int i = 0; i < accounts; ++i) {
+        text += cardName(i) + ",1234,100.00,Checking Account,Holder,0,0\n";
+    }
+    writeFile("bank_accounts.dat", text);
+}
+
+static Bank::Options lazyOptions(size_t residentAccounts) {
+    Bank::Options options;
+    options.format = Bank::StorageFormat::Csv;
+    options.lazyLoad = true;
+    options.shardCount = 1;
+    options.memoryBudgetBytes = residentAccounts * 230;
+    return options;
+}
+
+// An account used only through shared-lock operations (PIN checks and
+// balance changes of a resident account) must count as recently used and
+// survive a scan that pages in many others.
+static void hotAccountStaysResident() {
+    writeSnapshot(2000);
+    Bank bank(lazyOptions(64));
+    const std::string hot = cardName(0);
+    CHECK(bank.verifyPIN(hot, "1234"));
+    bool stayed = true;
+    for (int i = 1; i < 2000; ++i) {
+        CHECK(bank.verifyPIN(cardName(i), "1234"));
+        if (i % 16 == 0) {
+            stayed = stayed && bank.isResident(hot);
+            CHECK(bank.verifyPIN(hot, "1234"));
+        }
+    }
+    CHECK(stayed);
+    CHECK(bank.getResidentAccountCount() <= 80);
+}
+
+// Without shared use an account still ages out in LRU order.
+static void coldAccountIsEvicted() {
+    writeSnapshot(2000);
+    Bank bank(lazyOptions(64));
+    CHECK(bank.verifyPIN(cardName(0), "1234"));
+    for (int i = 1; i < 500; ++i) bank.verifyPIN(cardName(i), "1234");
+    CHECK(!bank.isResident(cardName(0)));
+    CHECK(bank.isResident(cardName(499)));
+}
+
+// End of day changes every account, yet a lazy bank commits them in groups
+// as it goes instead of pinning them all until the end.
+static void endOfDayStaysInBudget() {
+    removeBankFiles();
+    std::string text;
+    for (int i = 0; i < 2000; ++i) text += cardName(i) + ",1234,-10.00,Checking Account,Holder,0,0\n";
+    writeFile("bank_accounts.dat", text);
+    {
+        Bank bank(lazyOptions(64));
+        Bank::EndOfDayStats stats = bank.runEndOfDay(0.0, 25.0);
+        CHECK(stats.accounts == 2000 && stats.feesCharged == 2000);
+        CHECK(stats.peakResidentAccounts <= 80);
+        CHECK(bank.getResidentAccountCount() <= 80);
+    }
+    size_t groups = 0;
+    const std::string journal = readFile("bank_accounts.journal");
+    for (size_t at = journal.find("#commit"); at != std::string::npos; at = journal.find("#commit", at + 1)) groups++;
+    CHECK(groups > 1);
+    Bank reloaded(lazyOptions(64));
+    bool charged = true;
+    for (int i = 0; i < 2000; ++i) {
+        auto account = reloaded.getAccount(cardName(i));
+        charged = charged && account && account->getBalance() == -35.0;
+    }
+    CHECK(charged);
+}
+
+int main() {
+    hotAccountStaysResident();
+    coldAccountIsEvicted();
+    endOfDayStaysInBudget();
+    removeBankFiles();
+    return checkResult("LazyPagingTest");
+}
@@ -0,0 +1,115 @@
+#include "Check.h"
+#include "TransactionIdGenerator.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The clock the generators under test read; steps are up to the test.
+static int64_t fakeNow = TransactionIdGenerator::EPOCH_MS + 1000000000;
+static int64_t fakeClock() { return fakeNow; }
+
+static void removeLeases() {
+    for (uint32_t node : {0u, 1u, 7u}) {
+        std::remove((TransactionIdGenerator::ID_FILE_PREFIX + std::to_string(node) + ".dat").c_str());
+    }
+}
+
+static int64_t leaseOf(uint32_t node) {
+    std::string text = readFile(TransactionIdGenerator::ID_FILE_PREFIX + std::to_string(node) + ".dat");
+    return text.empty() ? -1 : std::stoll(text);
+}
+
+// Ids from concurrent threads and from two nodes never collide, and each
+// thread sees its own ids increase.
+static void idsAreUnique() {
+    removeLeases();
+    const int threadCount = 4;
+    const int perThread = 20000; // several ms worth of sequence numbers
+    TransactionIdGenerator first(0);
+    TransactionIdGenerator second(1);
+    std::vector<std::vector<uint64_t>> ids(threadCount * 2);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount * 2; ++t) {
+        threads.emplace_back([&, t] {
+            TransactionIdGenerator& generator = t % 2 ? second : first;
+            for (int i = 0; i < perThread; ++i) ids[t].push_back(generator.next());
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    bool increasing = true;
+    std::vector<uint64_t> all;
+    for (const auto& list : ids) {
+        increasing = increasing && std::is_sorted(list.begin(), list.end()) &&
+                     std::adjacent_find(list.begin(), list.end()) == list.end();
+        all.insert(all.end(), list.begin(), list.end());
+    }
+    std::sort(all.begin(), all.end());
+    CHECK(increasing);
+    CHECK(std::adjacent_find(all.begin(), all.end()) == all.end());
+    CHECK(first.node() == 0 && second.node() == 1);
+}
+
+// A restarted generator starts at the lease its predecessor wrote, so its
+// ids are above every earlier one even though the clock has not moved.
+static void restartStartsAboveLease() {
+    removeLeases();
+    uint64_t lastId = 0;
+    {
+        TransactionIdGenerator generator(7, fakeClock);
+        for (int i = 0; i < 100; ++i) lastId = generator.next();
+    }
+    const int64_t lease = leaseOf(7);
+    CHECK(lease > fakeNow - TransactionIdGenerator::EPOCH_MS);
+    TransactionIdGenerator restarted(7, fakeClock);
+    const uint64_t id = restarted.next();
+    CHECK(id > lastId);
+    CHECK(TransactionIdGenerator::timestampOf(id) >= lease + TransactionIdGenerator::EPOCH_MS);
+}
+
+// A clock that steps back is ignored, both while running and across a
+// restart that happens before it has caught up.
+static void clockStepBack() {
+    removeLeases();
+    fakeNow = TransactionIdGenerator::EPOCH_MS + 2000000000;
+    uint64_t lastId = 0;
+    {
+        TransactionIdGenerator generator(7, fakeClock);
+        lastId = generator.next();
+        fakeNow -= 60000;
+        bool increasing = true;
+        for (int i = 0; i < 5000; ++i) {
+            const uint64_t id = generator.next();
+            increasing = increasing && id > lastId;
+            lastId = id;
+        }
+        CHECK(increasing);
+    }
+    fakeNow -= 60000;
+    TransactionIdGenerator restarted(7, fakeClock);
+    CHECK(restarted.next() > lastId);
+}
+
+static void nodeOutOfRange() {
+    bool threw = false;
+    try {
+        TransactionIdGenerator generator(TransactionIdGenerator::MAX_NODE + 1);
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+    TransactionIdGenerator last(TransactionIdGenerator::MAX_NODE, fakeClock);
+    CHECK(last.node() == TransactionIdGenerator::MAX_NODE);
+}
+
+int main() {
+    idsAreUnique();
+    restartStartsAboveLease();
+    clockStepBack();
+    nodeOutOfRange();
+    removeLeases();
+    return checkResult("TransactionIdGeneratorTest");
+}
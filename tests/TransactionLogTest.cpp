@@ -0,0 +1,319 @@
+#include "Check.h"
+#include "TransactionLog.h"
+#include "DepositTransaction.h"
+#include "TransferTransaction.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// The log has one writer per process, which checks and opens the files on
+// first use, so every scenario that needs a restart runs in a child
+// process: the driver prepares the files, then runs itself with the
+// scenario's name.
+
+static const std::string LOG = "transaction_log.bin";
+static const std::string INDEX = "transaction_log.idx";
+static const std::string SEGMENTS = "transaction_log_segments";
+
+static void removeLogFiles() {
+    for (const std::string& name : {LOG, INDEX, LOG + ".unreadable", std::string("transaction_log.csv")}) {
+        std::remove(name.c_str());
+    }
+    std::error_code error;
+    std::filesystem::remove_all(SEGMENTS, error);
+    std::filesystem::remove_all("transaction_log_archive", error);
+}
+
+static TransactionSegment::Row deposit(uint64_t id, uint32_t card, int64_t cents) {
+    TransactionSegment::Row row;
+    row.id = id;
+    row.card = card;
+    row.cardDigits = 7;
+    row.type = TransactionSegment::TYPE_DEPOSIT;
+    row.amountCents = cents;
+    row.timestampMs = TimeFormat::now();
+    return row;
+}
+
+static TransactionSegment::Row transfer(uint64_t id, uint32_t from, uint32_t to, int64_t cents) {
+    TransactionSegment::Row row = deposit(id, from, cents);
+    row.type = TransactionSegment::TYPE_TRANSFER;
+    row.counterparty = to;
+    row.counterpartyDigits = 7;
+    return row;
+}
+
+// Writes a live segment holding blocks, one block per inner list, and
+// returns the file image.
+static std::string writeLog(uint64_t segmentId, const std::vector<std::vector<TransactionSegment::Row>>& blocks) {
+    std::string image = TransactionSegment::newFile(segmentId);
+    TransactionSegment::BlockBuilder builder;
+    for (const auto& rows : blocks) {
+        for (const TransactionSegment::Row& row : rows) builder.add(row);
+        builder.finish(image);
+    }
+    writeFile(LOG, image);
+    return image;
+}
+
+// Seals the live segment the way the writer does, without moving it: as
+// left by a crash between the two steps.
+static void sealInPlace(uint64_t segmentId, const std::vector<std::vector<TransactionSegment::Row>>& blocks) {
+    std::string image = writeLog(segmentId, blocks);
+    std::vector<TransactionSegment::AccountEntry> table;
+    std::vector<uint64_t> locations;
+    {
+        TransactionLogIndex index(LOG, INDEX);
+        index.accountTable(table, locations);
+    }
+    TransactionSegment::SegmentStats stats;
+    std::vector<uint64_t> offsets;
+    TransactionSegment::forEachBlock(image.data(), image.size(), 0, [&](uint64_t offset, const char*, size_t) {
+        offsets.push_back(offset);
+    });
+    for (const auto& rows : blocks) {
+        for (const TransactionSegment::Row& row : rows) stats.add(row);
+    }
+    TransactionSegment::SegmentHeader header = TransactionSegment::sealedHeader(segmentId, stats, image.size(), table);
+    const uint64_t blockCount = offsets.size();
+    image.append(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(TransactionSegment::AccountEntry));
+    image.append(reinterpret_cast<const char*>(locations.data()), locations.size() * sizeof(uint64_t));
+    image.append(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    image.append(reinterpret_cast<const char*>(&blockCount), sizeof(blockCount));
+    std::memcpy(&image[sizeof(TransactionSegment::FILE_MAGIC)], &header, sizeof(header));
+    std::remove(INDEX.c_str());
+    writeFile(LOG, image);
+}
+
+static std::vector<uint64_t> idsOf(const std::vector<TransactionRecord>& records) {
+    std::vector<uint64_t> ids;
+    for (const TransactionRecord& record : records) ids.push_back(record.id);
+    return ids;
+}
+
+static bool sameRecord(const TransactionRecord& a, const TransactionRecord& b) {
+    return a.id == b.id && a.account == b.account && a.accountDigits == b.accountDigits &&
+           a.counterparty == b.counterparty && a.counterpartyDigits == b.counterpartyDigits && a.type == b.type &&
+           a.amountCents == b.amountCents && a.timestampMs == b.timestampMs;
+}
+
+static void startChild() {
+    TransactionLog::Options options;
+    options.rotateDaily = false;
+    TransactionLog::configure(options);
+}
+
+// Child: the log holds records 1-4 and whatever followed them was dropped;
+// new records are appended after them.
+static void tailDropped() {
+    startChild();
+    CHECK(idsOf(TransactionLog::readTransactions()) == (std::vector<uint64_t>{1, 2, 3, 4}));
+    TransactionLog::logTransaction(DepositTransaction(100, "1000002", 5.0));
+    CHECK(idsOf(TransactionLog::readTransactions()) == (std::vector<uint64_t>{1, 2, 3, 4, 100}));
+    CHECK(idsOf(TransactionLog::readTransactions("1000002")) == (std::vector<uint64_t>{3, 4, 100}));
+}
+
+// Child: the sealed segment was moved and a new live segment started.
+static void sealedMoved() {
+    startChild();
+    std::error_code error;
+    size_t sealed = 0;
+    for (std::filesystem::directory_iterator it(SEGMENTS, error), end; !error && it != end; it.increment(error)) sealed++;
+    CHECK(sealed == 1);
+    MappedFile live;
+    TransactionSegment::SegmentHeader header{};
+    CHECK(live.open(LOG, false) && TransactionSegment::readHeader(live.data(), live.size(), header) &&
+          !(header.flags & TransactionSegment::SEALED) && live.size() == TransactionSegment::DATA_START);
+    live.close();
+    CHECK(idsOf(TransactionLog::readTransactions()) == (std::vector<uint64_t>{1, 2, 3, 4}));
+    CHECK(idsOf(TransactionLog::readTransactions("1000002")) == (std::vector<uint64_t>{2, 3, 4}));
+    TransactionLog::logTransaction(DepositTransaction(100, "1000001", 5.0));
+    CHECK(idsOf(TransactionLog::readTransactions("1000001")) == (std::vector<uint64_t>{1, 4, 100}));
+}
+
+// Child, after sealedMoved: a transfer is listed under both cards, and
+// cursor pages match readTransactions reversed, for the whole log and for
+// single accounts, in any page order.
+static void queries() {
+    startChild();
+    TransactionLog::logTransaction(TransferTransaction(101, "1000001", "1000003", 25.0));
+    for (uint64_t id = 102; id < 140; ++id) {
+        const std::string card = std::to_string(1000001 + id % 3);
+        if (id % 5 == 0) {
+            TransactionLog::logTransaction(TransferTransaction(id, card, "1000004", 1.0));
+        } else {
+            TransactionLog::logTransaction(DepositTransaction(id, id % 7 == 0 ? "CARD-X" : card, 2.0));
+        }
+        if (id % 4 == 0) TransactionLog::flush();
+    }
+
+    const std::vector<TransactionRecord> sender = TransactionLog::readTransactions("1000001");
+    const std::vector<TransactionRecord> recipient = TransactionLog::readTransactions("1000003");
+    auto find = [](const std::vector<TransactionRecord>& records, uint64_t id) {
+        return std::find_if(records.begin(), records.end(), [id](const TransactionRecord& r) { return r.id == id; });
+    };
+    // 1 is the sealed transfer, 101 the live one.
+    for (uint64_t id : {1ull, 101ull}) {
+        auto out = find(sender, id);
+        auto in = find(recipient, id);
+        CHECK(out != sender.end() && out->typeName() == "TRANSFER_OUT" && out->accountNumber() == "1000001" &&
+              out->counterpartyNumber() == "1000003");
+        CHECK(in != recipient.end() && in->typeName() == "TRANSFER_IN" && in->accountNumber() == "1000003" &&
+              in->counterpartyNumber() == "1000001");
+        CHECK(out != sender.end() && in != recipient.end() && out->amountCents == in->amountCents);
+    }
+
+    for (const std::string account : {"", "1000001", "1000003", "1000004", "CARD-X", "9999999"}) {
+        std::vector<TransactionRecord> expected = TransactionLog::readTransactions(account);
+        std::reverse(expected.begin(), expected.end());
+        for (size_t pageSize : {1, 3, 4, 7}) {
+            TransactionLog::Cursor cursor = TransactionLog::newestFirst(account, pageSize);
+            CHECK(cursor.records() == expected.size());
+            std::vector<TransactionRecord> forward;
+            for (size_t page = 0; page < cursor.pageCount(); ++page) {
+                const std::vector<TransactionRecord>& records = cursor.page(page);
+                forward.insert(forward.end(), records.begin(), records.end());
+            }
+            // Backwards, so every page is reached by seeking.
+            std::vector<TransactionRecord> backward;
+            for (size_t page = cursor.pageCount(); page-- > 0;) {
+                const std::vector<TransactionRecord>& records = cursor.page(page);
+                backward.insert(backward.begin(), records.begin(), records.end());
+            }
+            bool same = forward.size() == expected.size() && backward.size() == expected.size();
+            for (size_t i = 0; same && i < expected.size(); ++i) {
+                same = sameRecord(forward[i], expected[i]) && sameRecord(backward[i], expected[i]);
+            }
+            CHECK(same);
+            if (!same) std::cerr << "  account \"" << account << "\", " << pageSize << " per page\n";
+        }
+    }
+
+    size_t exported = 0;
+    CHECK(TransactionLog::exportCsv("first.csv", exported));
+    CHECK(exported == TransactionLog::readTransactions().size());
+}
+
+// Child, on an empty log: imports the export of queries and exports again.
+static void importExport() {
+    startChild();
+    size_t imported = 0;
+    CHECK(TransactionLog::importCsv("imported.csv", imported));
+    size_t exported = 0;
+    CHECK(TransactionLog::exportCsv("second.csv", exported));
+    CHECK(imported == exported && exported > 40);
+}
+
+static void runChild(const char* self, const char* scenario) {
+    const std::string command = std::string("\"") + self + "\" " + scenario;
+    const int status = std::system(command.c_str());
+    CHECK(status == 0);
+    if (status != 0) std::cerr << "  in " << scenario << "\n";
+}
+
+// A block torn by a crash mid-write, or one whose checksum fails, is cut
+// off the end of the live segment; the index is rebuilt without it.
+static void tornOrCorruptTail(const char* self) {
+    const std::vector<std::vector<TransactionSegment::Row>> kept = {
+        {deposit(1, 1000001, 100), deposit(2, 1000001, 200)},
+        {deposit(3, 1000002, 300), deposit(4, 1000002, 400)},
+    };
+    std::string lost;
+    TransactionSegment::BlockBuilder builder;
+    builder.add(deposit(5, 1000002, 500));
+    builder.add(deposit(6, 1000003, 600));
+    builder.finish(lost);
+
+    removeLogFiles();
+    std::string image = writeLog(7, kept);
+    {
+        TransactionLogIndex index(LOG, INDEX);
+        index.ensureLoaded();
+    }
+    writeFile(LOG, image + lost.substr(0, lost.size() - 3));
+    runChild(self, "tailDropped");
+
+    removeLogFiles();
+    lost.back() ^= 0x55;
+    writeFile(LOG, image + lost);
+    {
+        // An index that already covers the corrupt block.
+        TransactionLogIndex index(LOG, INDEX);
+        index.ensureLoaded();
+    }
+    runChild(self, "tailDropped");
+}
+
+static std::vector<uint64_t> locations(uint32_t card) {
+    TransactionLogIndex index(LOG, INDEX);
+    return index.locationsFor(card);
+}
+
+// The index is rebuilt when it belongs to another segment or its last
+// entry does not match the log, and catches up with blocks it missed.
+static void indexRebuilt() {
+    removeLogFiles();
+    writeLog(1, {{deposit(1, 1000001, 100), deposit(2, 1000001, 100)},
+                 {deposit(3, 1000002, 100), deposit(4, 1000002, 100)}});
+    CHECK(locations(1000001).size() == 2);
+    const std::string otherSegment = readFile(INDEX);
+
+    // Same block layout, so every old entry still points at a record.
+    writeLog(2, {{deposit(1, 1000002, 100), deposit(2, 1000002, 100)},
+                 {deposit(3, 1000002, 100), deposit(4, 1000002, 100)}});
+    writeFile(INDEX, otherSegment);
+    CHECK(locations(1000001).empty());
+    CHECK(locations(1000002).size() == 4);
+
+    std::string index = readFile(INDEX);
+    const uint32_t wrongCard = 1000009;
+    std::memcpy(&index[index.size() - sizeof(TransactionLogIndex::Entry) + sizeof(uint64_t)], &wrongCard,
+                sizeof(wrongCard));
+    writeFile(INDEX, index);
+    CHECK(locations(1000009).empty());
+    CHECK(locations(1000002).size() == 4);
+
+    // Lost the entries of the last block.
+    index = readFile(INDEX);
+    writeFile(INDEX, index.substr(0, index.size() - 2 * sizeof(TransactionLogIndex::Entry)));
+    CHECK(locations(1000002).size() == 4);
+    CHECK(readFile(INDEX) == index);
+}
+
+// A segment sealed but not moved before a crash is moved on restart; then
+// the queries and the CSV round trip run over it and a new live segment.
+static void sealedRestart(const char* self) {
+    removeLogFiles();
+    sealInPlace(3, {{transfer(1, 1000001, 1000003, 1500), deposit(2, 1000002, 100)},
+                    {deposit(3, 1000002, 200), transfer(4, 1000002, 1000001, 300)}});
+    runChild(self, "sealedMoved");
+    runChild(self, "queries");
+
+    std::string csv = readFile("first.csv");
+    writeFile("imported.csv", csv + "LEGACY-7,1000001,DEPOSIT,12.50,yesterday noon\nnot a record\n");
+    removeLogFiles();
+    runChild(self, "importExport");
+    CHECK(readFile("second.csv") == csv + "LEGACY-7,1000001,DEPOSIT,12.50,yesterday noon\n");
+    for (const char* name : {"first.csv", "imported.csv", "second.csv"}) std::remove(name);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        const std::string scenario = argv[1];
+        if (scenario == "tailDropped") tailDropped();
+        else if (scenario == "sealedMoved") sealedMoved();
+        else if (scenario == "queries") queries();
+        else if (scenario == "importExport") importExport();
+        else return 2;
+        return checkFailures() == 0 ? 0 : 1;
+    }
+
+    tornOrCorruptTail(argv[0]);
+    indexRebuilt();
+    sealedRestart(argv[0]);
+    removeLogFiles();
+    return checkResult("TransactionLogTest");
+}